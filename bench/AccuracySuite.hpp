@@ -0,0 +1,289 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <flecs.h>
+#include <limits>
+#include <numbers>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "components/Components.hpp"
+#include "core/Config.hpp"
+#include "core/Generators.hpp"
+#include "core/Scenario.hpp"
+#include "core/TrailPool.hpp"
+#include "physics/Gravity.hpp"
+#include "systems/Physics.hpp"
+
+namespace nbody::bench {
+
+// Accuracy against cost, to pick the cheapest settings that meet an error budget.
+// - Forces: Barnes-Hut over a sweep of opening angles against a direct-sum reference, reporting RMS and max
+//   relative acceleration error with the wall time of each backend.
+// - Orbits: two-body Kepler, the Chenciner-Montgomery figure-eight and a small Plummer sphere advanced with every
+//   integrator over a sweep of step sizes, reporting the worst relative energy error against wall time and the
+//   number of force evaluations. Steps follow the simulation pipeline (gravity, then integrate) with direct
+//   forces, so only the integrator varies.
+// Orbit problems use N-body units (G = 1).
+class AccuracySuite {
+public:
+    struct ForceResult {
+        std::string distribution;
+        std::size_t bodies = 0;
+        std::string backend;  // "direct" or "bh"
+        double theta = 0.0;
+        double seconds = 0.0;  // best of the repetitions
+        double rms_error = 0.0;
+        double max_error = 0.0;
+    };
+
+    struct OrbitResult {
+        std::string problem;
+        std::string integrator;
+        std::size_t bodies = 0;
+        double dt = 0.0;
+        std::uint64_t steps = 0;
+        std::uint64_t force_evaluations = 0;  // full O(N^2) passes; Hermite's also carry the jerk
+        double seconds = 0.0;
+        double energy_drift = 0.0;  // max |E - E0| / |E0| over the run
+    };
+
+    std::vector<ForceResult> forces;
+    std::vector<OrbitResult> orbits;
+
+    // Force sweeps use N = 10^3 .. maxBodies (the reference is O(N^2)); rmsBudget picks the fastest backend whose
+    // RMS error stays within it.
+    void run(const std::size_t maxBodies, const double minTime, const double rmsBudget) {
+        std::printf("\n%-10s %8s %-8s %6s %12s %12s %12s\n", "forces", "bodies", "backend", "theta", "time ms",
+                    "rms err", "max err");
+        for (const auto& [name, kind] : kDistributions) {
+            for (std::size_t n = 1000; n <= maxBodies; n *= 10) run_forces(name, kind, n, minTime, rmsBudget);
+        }
+        std::printf("\n%-10s %-20s %8s %10s %10s %10s %12s %12s\n", "orbits", "integrator", "bodies", "dt", "steps",
+                    "force evals", "time ms", "energy drift");
+        for (const Orbit& orbit : orbit_problems()) {
+            for (const Integrator& integrator : kIntegrators) {
+                for (const int stepsPerUnit : kStepsPerTimeUnit) run_orbit(orbit, integrator, stepsPerUnit);
+            }
+        }
+    }
+
+    void write_json(std::ostream& out) const {
+        std::array<char, 512> line{};
+        out << "  \"accuracy\": {\n    \"forces\": [";
+        for (std::size_t i = 0; i < forces.size(); ++i) {
+            const ForceResult& r = forces[i];
+            std::snprintf(line.data(), line.size(),
+                          "%s\n      {\"distribution\": \"%s\", \"bodies\": %zu, \"backend\": \"%s\", \"theta\": %.2f, "
+                          "\"seconds\": %.6g, \"rms_relative_error\": %.4g, \"max_relative_error\": %.4g}",
+                          i == 0 ? "" : ",", r.distribution.c_str(), r.bodies, r.backend.c_str(), r.theta, r.seconds,
+                          r.rms_error, r.max_error);
+            out << line.data();
+        }
+        out << "\n    ],\n    \"orbits\": [";
+        for (std::size_t i = 0; i < orbits.size(); ++i) {
+            const OrbitResult& r = orbits[i];
+            std::snprintf(line.data(), line.size(),
+                          "%s\n      {\"problem\": \"%s\", \"integrator\": \"%s\", \"bodies\": %zu, \"dt\": %.6g, "
+                          "\"steps\": %llu, \"force_evaluations\": %llu, \"seconds\": %.6g, \"energy_drift\": %.4g}",
+                          i == 0 ? "" : ",", r.problem.c_str(), r.integrator.c_str(), r.bodies, r.dt,
+                          static_cast<unsigned long long>(r.steps),
+                          static_cast<unsigned long long>(r.force_evaluations), r.seconds, r.energy_drift);
+            out << line.data();
+        }
+        out << "\n    ]\n  }";
+    }
+
+private:
+    struct Distribution {
+        const char* name;
+        Generators::Kind kind;
+    };
+    static constexpr std::array kDistributions = {Distribution{"uniform", Generators::Kind::ColdCollapse},
+                                                  Distribution{"plummer", Generators::Kind::Plummer},
+                                                  Distribution{"disk", Generators::Kind::ExponentialDisk}};
+    static constexpr std::array kThetas = {0.2, 0.3, 0.5, 0.7, 1.0, 1.2};
+
+    // Config::integrator values, their names and force evaluations per single-substep frame.
+    struct Integrator {
+        int id;
+        const char* name;
+        int evaluations_per_step;
+        int startup_evaluations;  // once per run: Hermite's forces and jerks at the initial state
+    };
+    static constexpr std::array kIntegrators = {Integrator{0, "semi_implicit_euler", 1, 0},
+                                                Integrator{1, "velocity_verlet", 2, 0},
+                                                Integrator{2, "hermite", 1, 1}};
+    static constexpr std::array kStepsPerTimeUnit = {32, 128, 512};
+    static constexpr int kEnergySamples = 64;
+    static constexpr std::uint64_t kSeed = 12345;
+
+    struct Orbit {
+        const char* name;
+        BodyBuffers bodies;
+        double softening = 0.0;
+        double duration = 0.0;
+    };
+
+    void run_forces(const char* name, const Generators::Kind kind, const std::size_t n, const double minTime,
+                    const double rmsBudget) {
+        Generators::Params params;
+        params.kind = kind;
+        params.count = n;
+        params.seed = kSeed;
+        const double G = constants::default_g;
+        const double eps2 = std::pow(Generators::suggested_softening(params), 2.0);
+        const BodyBuffers bodies = Generators::generate(params, G);
+        const std::vector<std::uint8_t> pins(n, 0);
+
+        std::vector<DVec2> reference(n);
+        const double directSeconds = best_seconds(minTime, [&] {
+            std::fill(reference.begin(), reference.end(), DVec2{});
+            Gravity::direct(bodies.positions, bodies.masses, pins, G, eps2, reference);
+        });
+        report_force(ForceResult{name, n, "direct", 0.0, directSeconds, 0.0, 0.0});
+
+        std::size_t fastest = forces.size() - 1;
+        std::vector<DVec2> acc(n);
+        for (const double theta : kThetas) {
+            const double seconds = best_seconds(minTime, [&] {
+                std::fill(acc.begin(), acc.end(), DVec2{});
+                Gravity::barnes_hut(bodies.positions, bodies.masses, pins, G, eps2, theta, acc);
+            });
+            double sumSq = 0.0;
+            double worst = 0.0;
+            std::size_t counted = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                const double ref = length(reference[i]);
+                if (ref <= 0.0) continue;
+                const double err = length(acc[i] - reference[i]) / ref;
+                sumSq += err * err;
+                worst = std::max(worst, err);
+                ++counted;
+            }
+            const double rms = counted ? std::sqrt(sumSq / static_cast<double>(counted)) : 0.0;
+            report_force(ForceResult{name, n, "bh", theta, seconds, rms, worst});
+            if (rms <= rmsBudget && seconds < forces[fastest].seconds) fastest = forces.size() - 1;
+        }
+        if (forces[fastest].backend == "bh") {
+            std::printf("  fastest within rms %.1e: bh theta %.2f\n", rmsBudget, forces[fastest].theta);
+        } else {
+            std::printf("  fastest within rms %.1e: direct\n", rmsBudget);
+        }
+    }
+
+    void report_force(const ForceResult& r) {
+        std::printf("%-10s %8zu %-8s %6.2f %12.3f %12.3g %12.3g\n", r.distribution.c_str(), r.bodies,
+                    r.backend.c_str(), r.theta, r.seconds * 1e3, r.rms_error, r.max_error);
+        forces.push_back(r);
+    }
+
+    void run_orbit(const Orbit& orbit, const Integrator& integrator, const int stepsPerUnit) {
+        flecs::world w;
+        w.set<Config>({});
+        w.set<TrailPool>({});
+        w.set<Physics::GravityTree>({});
+        Config& cfg = *w.get_mut<Config>();
+        const double dt = 1.0 / stepsPerUnit;
+        cfg.g = 1.0;
+        cfg.softening = static_cast<float>(orbit.softening);
+        cfg.bh_threshold = std::numeric_limits<int>::max();
+        cfg.integrator = integrator.id;
+        cfg.max_substep = static_cast<float>(dt);
+        assign_bodies(w, orbit.bodies.columns());
+
+        const double eps2 = orbit.softening * orbit.softening;
+        Physics::Diagnostics d{};
+        Physics::compute_diagnostics(w, cfg.g, eps2, d);
+        const double e0 = d.energy;
+        const auto steps = static_cast<std::uint64_t>(std::llround(orbit.duration * stepsPerUnit));
+        const std::uint64_t sampleEvery = std::max<std::uint64_t>(1, steps / kEnergySamples);
+
+        double drift = 0.0;
+        double seconds = 0.0;
+        for (std::uint64_t s = 1; s <= steps; ++s) {
+            const auto t0 = std::chrono::steady_clock::now();
+            if (Physics::needs_gravity_pass(cfg)) Physics::compute_gravity(w);
+            Physics::integrate(w, static_cast<float>(dt));
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            if (s % sampleEvery == 0 || s == steps) {
+                Physics::compute_diagnostics(w, cfg.g, eps2, d);
+                drift = std::max(drift, std::abs(d.energy - e0) / std::abs(e0));
+            }
+        }
+        const std::uint64_t evaluations = steps * static_cast<std::uint64_t>(integrator.evaluations_per_step) +
+            static_cast<std::uint64_t>(integrator.startup_evaluations);
+        const OrbitResult r{orbit.name, integrator.name, orbit.bodies.size(), dt, steps, evaluations, seconds, drift};
+        std::printf("%-10s %-20s %8zu %10.3g %10llu %10llu %12.3f %12.3g\n", r.problem.c_str(),
+                    r.integrator.c_str(), r.bodies, r.dt, static_cast<unsigned long long>(r.steps),
+                    static_cast<unsigned long long>(r.force_evaluations), r.seconds * 1e3, r.energy_drift);
+        orbits.push_back(r);
+    }
+
+    static auto orbit_problems() -> std::vector<Orbit> {
+        std::vector<Orbit> problems;
+
+        // Equal-mass Kepler pair, a = 1, e = 0.5, starting at apocentre; period 2 pi, run for 5 orbits.
+        {
+            Orbit o{"kepler", {}, 0.0, 10.0 * std::numbers::pi};
+            const double e = 0.5;
+            const double apo = 1.0 + e;
+            const double vRel = std::sqrt((1.0 - e) / apo);  // G (m1 + m2) = 1
+            o.bodies.resize(2);
+            o.bodies.positions = {DVec2{-0.5 * apo, 0.0}, DVec2{0.5 * apo, 0.0}};
+            o.bodies.velocities = {DVec2{0.0, -0.5 * vRel}, DVec2{0.0, 0.5 * vRel}};
+            o.bodies.masses = {0.5F, 0.5F};
+            o.bodies.tints = {RED, BLUE};
+            problems.push_back(std::move(o));
+        }
+        // Figure-eight choreography (Chenciner & Montgomery 2000), period 6.3259, run for 3 periods.
+        {
+            Orbit o{"figure8", {}, 0.0, 3.0 * 6.32591398};
+            const DVec2 x1{0.97000436, -0.24308753};
+            const DVec2 v3{-0.93240737, -0.86473146};
+            o.bodies.resize(3);
+            o.bodies.positions = {x1, x1 * -1.0, DVec2{}};
+            o.bodies.velocities = {v3 * -0.5, v3 * -0.5, v3};
+            o.bodies.masses = {1.0F, 1.0F, 1.0F};
+            o.bodies.tints = {RED, GREEN, BLUE};
+            problems.push_back(std::move(o));
+        }
+        // Plummer sphere, M = a = 1, run for about five crossing times.
+        {
+            Generators::Params params;
+            params.kind = Generators::Kind::Plummer;
+            params.count = 256;
+            params.seed = kSeed;
+            params.total_mass = 1.0;
+            params.scale_radius = 1.0;
+            Orbit o{"plummer", Generators::generate(params, 1.0), 0.05, 10.0};
+            problems.push_back(std::move(o));
+        }
+        return problems;
+    }
+
+    template <typename F>
+    static auto best_seconds(const double minTime, F&& fn) -> double {
+        fn();  // warm-up
+        double best = std::numeric_limits<double>::max();
+        double total = 0.0;
+        for (int rep = 0; rep == 0 || total < minTime; ++rep) {
+            const auto t0 = std::chrono::steady_clock::now();
+            fn();
+            const double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            best = std::min(best, dt);
+            total += dt;
+        }
+        return best;
+    }
+};
+
+}  // namespace nbody::bench
@@ -0,0 +1,340 @@
+// Benchmarks for the physics kernels on generated body distributions.
+//
+//   nbody_bench [--suite kernels|accuracy|all] [--filter TEXT] [--min-n N] [--max-n N] [--quadratic-max N]
+//               [--min-time S] [--error-budget E] [--out FILE]
+//
+// kernels (default): every kernel runs on uniform, Plummer and disk bodies for N = 10^2 .. 10^6; O(N^2) kernels
+// stop at --quadratic-max. Each case repeats until --min-time seconds have elapsed (after one untimed warm-up call)
+// and reports time per call, ns per interaction, bodies per second and heap allocations per call.
+// accuracy: force error and energy drift against cost (see AccuracySuite.hpp); --error-budget is the RMS relative
+// force error used to name the fastest acceptable backend.
+// Results are printed as tables and written as JSON (default nbody_bench.json) for tracking regressions between
+// releases.
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <exception>
+#include <flecs.h>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "AccuracySuite.hpp"
+#include "components/Components.hpp"
+#include "core/AllocationCounter.hpp"
+#include "core/Config.hpp"
+#include "core/Generators.hpp"
+#include "core/Scenario.hpp"
+#include "core/TrailPool.hpp"
+#include "physics/SpatialPartition.hpp"
+#include "systems/Collision.hpp"
+#include "systems/Physics.hpp"
+
+namespace {
+
+using nbody::BodyBuffers;
+using nbody::Generators;
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    bool kernels = true;
+    bool accuracy = false;
+    std::string filter;
+    std::size_t min_n = 100;
+    std::size_t max_n = 1000000;
+    std::size_t quadratic_max = 10000;
+    double min_time = 0.2;  // seconds per case
+    double error_budget = 1e-3;  // RMS relative force error
+    std::string out = "nbody_bench.json";
+};
+
+constexpr std::string_view kUsage = "usage: nbody_bench [--suite kernels|accuracy|all] [--filter TEXT] [--min-n N] "
+                                    "[--max-n N] [--quadratic-max N] [--min-time S] [--error-budget E] [--out FILE]";
+constexpr std::uint64_t kSeed = 12345;
+constexpr std::uint64_t kMaxIterations = 1000000;
+
+struct Distribution {
+    const char* name;
+    Generators::Kind kind;
+};
+constexpr std::array kDistributions = {Distribution{"uniform", Generators::Kind::ColdCollapse},
+                                       Distribution{"plummer", Generators::Kind::Plummer},
+                                       Distribution{"disk", Generators::Kind::ExponentialDisk}};
+
+// Bodies and world shared by every kernel of one distribution and size.
+struct Case {
+    flecs::world world;
+    BodyBuffers bodies;
+    std::vector<nbody::SpatialPartition::Body> tree_bodies;
+    nbody::SpatialPartition tree;
+
+    // Reset the world's bodies to the generated ones and return its Config.
+    Config& reset() {
+        nbody::assign_bodies(world, bodies.columns());
+        return *world.get_mut<Config>();
+    }
+};
+
+// What ns_per_interaction divides by: body pairs for pairwise kernels, N log2 N for the tree walk (a nominal
+// count; the real one depends on theta and the distribution), bodies for linear passes.
+enum class Work : std::uint8_t { Pairs, TreeWalk, Bodies };
+
+auto work_name(const Work work) -> const char* {
+    switch (work) {
+        case Work::Pairs: return "pairs";
+        case Work::TreeWalk: return "n_log2_n";
+        case Work::Bodies: return "bodies";
+    }
+    return "";
+}
+
+auto interactions(const Work work, const std::size_t n) -> double {
+    const auto nd = static_cast<double>(n);
+    switch (work) {
+        case Work::Pairs: return nd * (nd - 1.0) / 2.0;
+        case Work::TreeWalk: return nd * std::max(1.0, std::log2(nd));
+        case Work::Bodies: return nd;
+    }
+    return nd;
+}
+
+struct Kernel {
+    const char* name;
+    Work work;
+    bool quadratic;
+    // Untimed setup; returns the call to time.
+    std::function<void()> (*prepare)(Case&);
+};
+
+const std::array kKernels = {
+    Kernel{"compute_gravity_direct", Work::Pairs, true,
+           [](Case& c) -> std::function<void()> {
+               c.reset().bh_threshold = std::numeric_limits<int>::max();
+               return [&c] { nbody::Physics::compute_gravity(c.world); };
+           }},
+    Kernel{"compute_gravity_bh", Work::TreeWalk, false,
+           [](Case& c) -> std::function<void()> {
+               c.reset().bh_threshold = 0;
+               return [&c] { nbody::Physics::compute_gravity(c.world); };
+           }},
+    Kernel{"spatial_partition_build", Work::Bodies, false,
+           [](Case& c) -> std::function<void()> {
+               c.tree_bodies.clear();
+               for (std::size_t i = 0; i < c.bodies.size(); ++i) {
+                   c.tree_bodies.push_back({raylib::Vector2{static_cast<float>(c.bodies.positions[i].x),
+                                                            static_cast<float>(c.bodies.positions[i].y)},
+                                            c.bodies.masses[i], static_cast<int>(i)});
+               }
+               return [&c] { c.tree.build(c.tree_bodies); };
+           }},
+    // The warm-up call merges whatever overlaps initially, so the timed calls measure detection.
+    Kernel{"collision_resolve", Work::Pairs, true,
+           [](Case& c) -> std::function<void()> {
+               c.reset();
+               return [&c] { nbody::systems::Collision::resolve(c.world); };
+           }},
+    // Semi-implicit Euler with one substep: the update pass alone, no gravity.
+    Kernel{"integrate", Work::Bodies, false,
+           [](Case& c) -> std::function<void()> {
+               Config& cfg = c.reset();
+               cfg.integrator = 0;
+               const float dt = cfg.fixed_dt * cfg.time_scale;
+               cfg.max_substep = dt;
+               return [&c, dt] { nbody::Physics::integrate(c.world, dt); };
+           }},
+    Kernel{"update_trails", Work::Bodies, false,
+           [](Case& c) -> std::function<void()> {
+               c.reset().draw_trails = true;
+               return [&c] { nbody::Physics::update_trails(c.world); };
+           }},
+};
+
+struct Result {
+    std::string name;
+    const Kernel* kernel = nullptr;
+    const char* distribution = "";
+    std::size_t bodies = 0;
+    std::uint64_t iterations = 0;
+    double mean_ns = 0.0;
+    double min_ns = 0.0;
+    double ns_per_interaction = 0.0;
+    double bodies_per_second = 0.0;
+    double allocations_per_call = 0.0;
+};
+
+void measure(const std::function<void()>& call, const double minTime, Result& r) {
+    call();  // warm-up: caches, lazily grown buffers, first-call merges
+    double total = 0.0;
+    double best = std::numeric_limits<double>::max();
+    const std::uint64_t allocationsBefore = nbody::AllocationCounter::total();
+    while (r.iterations < kMaxIterations && (r.iterations == 0 || total < minTime)) {
+        const auto t0 = Clock::now();
+        call();
+        const double dt = std::chrono::duration<double>(Clock::now() - t0).count();
+        total += dt;
+        best = std::min(best, dt);
+        ++r.iterations;
+    }
+    const auto iterations = static_cast<double>(r.iterations);
+    r.mean_ns = total / iterations * 1e9;
+    r.min_ns = best * 1e9;
+    r.ns_per_interaction = r.mean_ns / interactions(r.kernel->work, r.bodies);
+    r.bodies_per_second = static_cast<double>(r.bodies) / (total / iterations);
+    r.allocations_per_call =
+        static_cast<double>(nbody::AllocationCounter::total() - allocationsBefore) / iterations;
+}
+
+auto parse_size(const std::string_view text) -> std::size_t {
+    std::size_t value = 0;
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc{} || end != text.data() + text.size() || value == 0)
+        throw std::invalid_argument("bad count " + std::string(text));
+    return value;
+}
+
+auto parse_seconds(const std::string_view text) -> double {
+    double value = 0.0;
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc{} || end != text.data() + text.size() || !(value >= 0.0))
+        throw std::invalid_argument("bad number " + std::string(text));
+    return value;
+}
+
+auto parse_options(const int argc, char** argv) -> Options {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc)
+            throw std::invalid_argument(std::string(arg) + " needs a value (" + std::string(kUsage) + ")");
+        const std::string_view value = argv[++i];
+        if (arg == "--suite") {
+            if (value != "kernels" && value != "accuracy" && value != "all")
+                throw std::invalid_argument("unknown suite " + std::string(value));
+            options.kernels = value != "accuracy";
+            options.accuracy = value != "kernels";
+        } else if (arg == "--filter") {
+            options.filter = value;
+        } else if (arg == "--min-n") {
+            options.min_n = parse_size(value);
+        } else if (arg == "--max-n") {
+            options.max_n = parse_size(value);
+        } else if (arg == "--quadratic-max") {
+            options.quadratic_max = parse_size(value);
+        } else if (arg == "--min-time") {
+            options.min_time = parse_seconds(value);
+        } else if (arg == "--error-budget") {
+            options.error_budget = parse_seconds(value);
+        } else if (arg == "--out") {
+            options.out = value;
+        } else {
+            throw std::invalid_argument("unknown option " + std::string(arg) + " (" + std::string(kUsage) + ")");
+        }
+    }
+    return options;
+}
+
+void write_json(const std::string& path, const Options& options, const std::vector<Result>& results,
+                const nbody::bench::AccuracySuite& accuracy) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) throw std::runtime_error("cannot write " + path);
+    std::array<char, 32> date{};
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date.data(), date.size(), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+#if defined(NDEBUG)
+    const char* build = "release";
+#else
+    const char* build = "debug";
+#endif
+    out << "{\n  \"context\": {\n"
+        << "    \"date\": \"" << date.data() << "\",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+        << "    \"build_type\": \"" << build << "\",\n"
+        << "    \"min_time_s\": " << options.min_time << ",\n"
+        << "    \"seed\": " << kSeed << "\n  },\n  \"benchmarks\": [";
+    std::array<char, 512> line{};
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::snprintf(line.data(), line.size(),
+                      "%s\n    {\"name\": \"%s\", \"kernel\": \"%s\", \"distribution\": \"%s\", \"bodies\": %zu, "
+                      "\"iterations\": %llu, \"time_unit\": \"ns\", \"real_time\": %.1f, \"min_time\": %.1f, "
+                      "\"interaction_unit\": \"%s\", \"ns_per_interaction\": %.4g, \"bodies_per_second\": %.4g, "
+                      "\"allocations_per_call\": %.2f}",
+                      i == 0 ? "" : ",", r.name.c_str(), r.kernel->name, r.distribution, r.bodies,
+                      static_cast<unsigned long long>(r.iterations), r.mean_ns, r.min_ns, work_name(r.kernel->work),
+                      r.ns_per_interaction, r.bodies_per_second, r.allocations_per_call);
+        out << line.data();
+    }
+    out << "\n  ]";
+    if (options.accuracy) {
+        out << ",\n";
+        accuracy.write_json(out);
+    }
+    out << "\n}\n";
+}
+
+void run_kernels(const Options& options, std::vector<Result>& results) {
+    std::printf("%-44s %10s %14s %12s %14s %10s\n", "benchmark", "iters", "time/call ns", "ns/inter", "bodies/s",
+                "allocs");
+    for (const Distribution& dist : kDistributions) {
+        for (std::size_t n = 100; n <= options.max_n; n *= 10) {
+            if (n < options.min_n) continue;
+            Case c;
+            c.world.set<Config>({});
+            c.world.set<nbody::TrailPool>({});
+            c.world.set<nbody::Physics::GravityTree>({});
+            Generators::Params params;
+            params.kind = dist.kind;
+            params.count = n;
+            params.seed = kSeed;
+            c.world.get_mut<Config>()->softening = static_cast<float>(Generators::suggested_softening(params));
+            c.bodies = Generators::generate(params, c.world.get<Config>()->g);
+
+            for (const Kernel& kernel : kKernels) {
+                if (kernel.quadratic && n > options.quadratic_max) continue;
+                Result r;
+                r.name = std::string(kernel.name) + "/" + dist.name + "/" + std::to_string(n);
+                if (!options.filter.empty() && r.name.find(options.filter) == std::string::npos) continue;
+                r.kernel = &kernel;
+                r.distribution = dist.name;
+                r.bodies = n;
+                measure(kernel.prepare(c), options.min_time, r);
+                std::printf("%-44s %10llu %14.0f %12.3g %14.4g %10.1f\n", r.name.c_str(),
+                            static_cast<unsigned long long>(r.iterations), r.mean_ns, r.ns_per_interaction,
+                            r.bodies_per_second, r.allocations_per_call);
+                std::fflush(stdout);
+                results.push_back(std::move(r));
+            }
+        }
+    }
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+    try {
+        const Options options = parse_options(argc, argv);
+        nbody::AllocationCounter::set_enabled(true);
+        std::vector<Result> results;
+        if (options.kernels) run_kernels(options, results);
+        nbody::bench::AccuracySuite accuracy;
+        if (options.accuracy) accuracy.run(options.quadratic_max, options.min_time, options.error_budget);
+        write_json(options.out, options, results, accuracy);
+        std::printf("wrote %s\n", options.out.c_str());
+        return 0;
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "nbody_bench: %s\n", e.what());
+        return 1;
+    }
+}
@@ -1,15 +1,21 @@
 #pragma once
 
+#include <cstdint>
 #include <raylib-cpp.hpp>
 #include <vector>
 
 #include "../core/Constants.hpp"
 #include "../core/Math.hpp"
+#include "../core/TrailPool.hpp"
 
 // Basic physics/render components
 struct Position {
     DVec2 value;
 };
+// Position at the start of the last simulation step; used to interpolate rendering between steps
+struct PrevPosition {
+    DVec2 value;
+};
 struct Velocity {
     DVec2 value;
 };
@@ -40,9 +46,9 @@ struct Tint {
     raylib::Color value;
 };
 
-// Trail history per entity
+// Trail history lives in the world's TrailPool; slot is assigned on the first trail update
 struct Trail {
-    std::vector<raylib::Vector2> points;
+    std::uint32_t slot = nbody::TrailPool::kNoSlot;
 };
 
 // Selection and interaction components
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace nbody {
+
+// Counts heap allocations, per thread and process-wide. It is fed by the global operator new replacement in
+// AllocationHooks.cpp (replacements must be defined exactly once per program); without it all counts stay zero.
+// Counting is opt-in: until set_enabled(true) the hook only forwards to malloc.
+class AllocationCounter {
+public:
+    static void record(const std::size_t bytes) noexcept {
+        if (!s_enabled.load(std::memory_order_relaxed)) return;
+        ++t_count;
+        t_bytes += bytes;
+        s_total.fetch_add(1, std::memory_order_relaxed);
+        s_total_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    static void set_enabled(const bool on) noexcept { s_enabled.store(on, std::memory_order_relaxed); }
+    [[nodiscard]] static auto enabled() noexcept -> bool { return s_enabled.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] static auto thread_count() noexcept -> std::uint64_t { return t_count; }
+    [[nodiscard]] static auto thread_bytes() noexcept -> std::uint64_t { return t_bytes; }
+    [[nodiscard]] static auto total() noexcept -> std::uint64_t { return s_total.load(std::memory_order_relaxed); }
+    [[nodiscard]] static auto total_bytes() noexcept -> std::uint64_t {
+        return s_total_bytes.load(std::memory_order_relaxed);
+    }
+
+    // Allocations made on the current thread since construction.
+    class Scope {
+    public:
+        Scope() noexcept : count_(t_count), bytes_(t_bytes) {}
+        [[nodiscard]] auto count() const noexcept -> std::uint64_t { return t_count - count_; }
+        [[nodiscard]] auto bytes() const noexcept -> std::uint64_t { return t_bytes - bytes_; }
+
+    private:
+        std::uint64_t count_;
+        std::uint64_t bytes_;
+    };
+
+private:
+    static inline thread_local std::uint64_t t_count = 0;
+    static inline thread_local std::uint64_t t_bytes = 0;
+    static inline std::atomic<std::uint64_t> s_total{0};
+    static inline std::atomic<std::uint64_t> s_total_bytes{0};
+    static inline std::atomic<bool> s_enabled{false};
+};
+
+}  // namespace nbody
@@ -0,0 +1,15 @@
+// Global allocation hooks feeding nbody::AllocationCounter (array and nothrow forms forward to these).
+// Replacements must be defined once per program, so every executable lists this file in its sources.
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "AllocationCounter.hpp"
+
+auto operator new(const std::size_t size) -> void* {
+    nbody::AllocationCounter::record(size);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
@@ -0,0 +1,351 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <flecs.h>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#include "../components/Components.hpp"
+#include "Config.hpp"
+#include "MappedFile.hpp"
+#include "Scenario.hpp"
+
+namespace nbody {
+
+// Full simulation state for resuming a run bit-exactly (*.nbchk).
+//
+// Layout (native little-endian): Header, the Config object as raw bytes, then one 64-byte aligned array per
+// column, shaped like the ECS components so capture and restore are straight copies. Files are written to a
+// temporary name, flushed to disk and renamed over the previous checkpoint, so a crash at any point leaves
+// either the old or the new checkpoint intact; a checksum catches anything the file system lets through.
+//
+// There is no RNG state to save: the step loop draws no random numbers, and generators take an explicit seed
+// (Generators::Params::seed) that Config and the bodies already reflect. The only runtime randomness is raylib's
+// GetRandomValue() picking tints for bodies spawned from the UI or mouse, i.e. user input, which a resumed run
+// does not replay anyway.
+//
+// Under the Hermite integrator the jerk column (with Acceleration) holds the forces the last step carried over, so
+// the resumed run starts from them instead of re-evaluating; restore() reports the created entities, in image
+// order, so the caller can hand them on (see Checkpointer::restore).
+class Checkpoint {
+public:
+    static constexpr std::array<char, 8> kMagic{'N', 'B', 'O', 'D', 'Y', 'C', 'H', 'K'};
+    static constexpr std::uint32_t kVersion = 2;
+    static constexpr std::uint32_t kEndianMark = 0x01020304;
+    static constexpr std::size_t kAlignment = 64;
+    static constexpr const char* kExtension = ".nbchk";
+
+    enum Column : std::uint32_t {
+        kPosition,
+        kPrevPosition,
+        kVelocity,
+        kAcceleration,
+        kPrevAcceleration,
+        kMass,
+        kPinned,
+        kTint,
+        kFlags,
+        kRadius,
+        kDensity,
+        kJerk,
+        kColumnCount
+    };
+
+    // Per-body optional components.
+    enum Flags : std::uint8_t { kHasRadius = 1, kHasDensity = 2 };
+
+    struct Block {
+        std::uint64_t offset = 0;
+        std::uint64_t size = 0;
+    };
+
+    struct Header {
+        std::array<char, 8> magic = kMagic;
+        std::uint32_t version = kVersion;
+        std::uint32_t header_size = sizeof(Header);
+        std::uint32_t endian = kEndianMark;
+        std::uint32_t config_size = sizeof(Config);  // checkpoints only restore into the build that wrote them
+        std::uint64_t body_count = 0;
+        std::uint64_t step = 0;
+        double sim_time = 0.0;
+        double governor_ema_ms = 0.0;
+        std::int32_t governor_cooldown = 0;
+        std::int32_t governor_adjustments = 0;
+        std::uint32_t hermite_forces = 0;  // accelerations and jerks are the Hermite integrator's carried-over forces
+        std::uint32_t reserved = 0;
+        std::uint64_t checksum = 0;  // FNV-1a over everything after the header
+        Block config;
+        std::array<Block, kColumnCount> columns{};
+    };
+
+    // Captured state; buffers keep their capacity between captures.
+    struct Image {
+        Config config{};
+        std::uint64_t step = 0;
+        double sim_time = 0.0;
+        double governor_ema_ms = 0.0;
+        int governor_cooldown = 0;
+        int governor_adjustments = 0;
+        bool hermite_forces = false;
+        std::vector<flecs::entity_t> ids;  // captured entities; not saved
+        std::vector<Position> positions;
+        std::vector<PrevPosition> prev_positions;
+        std::vector<Velocity> velocities;
+        std::vector<Acceleration> accelerations;
+        std::vector<PrevAcceleration> prev_accelerations;
+        std::vector<Mass> masses;
+        std::vector<Pinned> pinned;
+        std::vector<Tint> tints;
+        std::vector<std::uint8_t> flags;
+        std::vector<Radius> radii;  // meaningful where flags has kHasRadius
+        std::vector<Density> densities;  // meaningful where flags has kHasDensity
+        std::vector<DVec2> jerks;  // meaningful when hermite_forces
+
+        [[nodiscard]] auto size() const -> std::size_t { return positions.size(); }
+
+        void clear() {
+            hermite_forces = false;
+            ids.clear();
+            positions.clear();
+            prev_positions.clear();
+            velocities.clear();
+            accelerations.clear();
+            prev_accelerations.clear();
+            masses.clear();
+            pinned.clear();
+            tints.clear();
+            flags.clear();
+            radii.clear();
+            densities.clear();
+            jerks.clear();
+        }
+    };
+
+    // Copy the world's bodies and Config into img in one pass, in iteration order (which restore() reproduces).
+    static void capture(const flecs::world& w, Image& img) {
+        img.clear();
+        if (const auto* cfg = w.get<Config>()) img.config = *cfg;
+        w.each([&](const flecs::entity e, const Position& p, const PrevPosition& pp, const Velocity& v,
+                   const Acceleration& a, const PrevAcceleration& pa, const Mass& m, const Pinned& pin, const Tint& t,
+                   const Radius* r, const Density* d) {
+            img.ids.push_back(e.id());
+            img.positions.push_back(p);
+            img.prev_positions.push_back(pp);
+            img.velocities.push_back(v);
+            img.accelerations.push_back(a);
+            img.prev_accelerations.push_back(pa);
+            img.masses.push_back(m);
+            img.pinned.push_back(pin);
+            img.tints.push_back(t);
+            img.flags.push_back(static_cast<std::uint8_t>((r ? kHasRadius : 0) | (d ? kHasDensity : 0)));
+            img.radii.push_back(r ? *r : Radius{0.0});
+            img.densities.push_back(d ? *d : Density{});
+            img.jerks.push_back(DVec2{0.0, 0.0});
+        });
+    }
+
+    static bool save(const std::filesystem::path& path, const Image& img) {
+        const std::size_t n = img.size();
+        Header h{};
+        h.body_count = n;
+        h.step = img.step;
+        h.sim_time = img.sim_time;
+        h.governor_ema_ms = img.governor_ema_ms;
+        h.governor_cooldown = img.governor_cooldown;
+        h.governor_adjustments = img.governor_adjustments;
+        h.hermite_forces = img.hermite_forces ? 1 : 0;
+        std::uint64_t at = sizeof(Header);
+        h.config = Block{at, sizeof(Config)};
+        at += sizeof(Config);
+        for (std::uint32_t c = 0; c < kColumnCount; ++c) {
+            at = align(at);
+            h.columns[c] = Block{at, kStride[c] * n};
+            at += h.columns[c].size;
+        }
+        const std::array<const void*, kColumnCount> data{
+            img.positions.data(),     img.prev_positions.data(), img.velocities.data(), img.accelerations.data(),
+            img.prev_accelerations.data(), img.masses.data(),    img.pinned.data(),     img.tints.data(),
+            img.flags.data(),         img.radii.data(),          img.densities.data(),  img.jerks.data()};
+
+        // Checksum the payload exactly as it will be laid out, padding included.
+        std::uint64_t hash = kFnvOffset;
+        std::uint64_t pos = sizeof(Header);
+        const auto hash_bytes = [&](const void* p, const std::size_t bytes) {
+            hash = fnv1a(hash, static_cast<const unsigned char*>(p), bytes);
+            pos += bytes;
+        };
+        const auto hash_pad = [&](const std::uint64_t offset) {
+            while (pos < offset)
+                hash_bytes(kZeros.data(), static_cast<std::size_t>(std::min<std::uint64_t>(offset - pos, kAlignment)));
+        };
+        hash_bytes(&img.config, sizeof(Config));
+        for (std::uint32_t c = 0; c < kColumnCount; ++c) {
+            hash_pad(h.columns[c].offset);
+            hash_bytes(data[c], static_cast<std::size_t>(h.columns[c].size));
+        }
+        h.checksum = hash;
+
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+        const auto tmp = std::filesystem::path(path).concat(".tmp");
+        std::FILE* out = std::fopen(tmp.string().c_str(), "wb");
+        if (!out) return false;
+        bool ok = write_raw(out, &h, sizeof(h)) && write_raw(out, &img.config, sizeof(Config));
+        std::uint64_t written = sizeof(Header) + sizeof(Config);
+        for (std::uint32_t c = 0; ok && c < kColumnCount; ++c) {
+            ok = write_raw(out, kZeros.data(), static_cast<std::size_t>(h.columns[c].offset - written)) &&
+                write_raw(out, data[c], static_cast<std::size_t>(h.columns[c].size));
+            written = h.columns[c].offset + h.columns[c].size;
+        }
+        ok = ok && std::fflush(out) == 0 && sync_file(out);
+        ok = (std::fclose(out) == 0) && ok;
+        if (!ok) {
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+        std::filesystem::rename(tmp, path, ec);
+        return !ec;
+    }
+
+    // Read and verify a checkpoint; false on any mismatch (including one written by a different build).
+    static bool load(const std::filesystem::path& path, Image& img) {
+        MappedFile file;
+        if (!file.open(path) || file.size() < sizeof(Header)) return false;
+        const std::byte* base = file.data();
+        const std::size_t size = file.size();
+        Header h{};
+        std::memcpy(&h, base, sizeof(h));
+        if (h.magic != kMagic || h.version != kVersion || h.endian != kEndianMark || h.header_size != sizeof(Header) ||
+            h.config_size != sizeof(Config))
+            return false;
+        const auto inside = [&](const Block& b) { return b.offset <= size && b.size <= size - b.offset; };
+        if (!inside(h.config) || h.config.size != sizeof(Config)) return false;
+        for (std::uint32_t c = 0; c < kColumnCount; ++c) {
+            if (!inside(h.columns[c]) || h.columns[c].size != kStride[c] * h.body_count) return false;
+        }
+        if (fnv1a(kFnvOffset, reinterpret_cast<const unsigned char*>(base + sizeof(Header)), size - sizeof(Header)) !=
+            h.checksum)
+            return false;
+
+        const auto n = static_cast<std::size_t>(h.body_count);
+        std::memcpy(&img.config, base + h.config.offset, sizeof(Config));
+        img.step = h.step;
+        img.sim_time = h.sim_time;
+        img.governor_ema_ms = h.governor_ema_ms;
+        img.governor_cooldown = h.governor_cooldown;
+        img.governor_adjustments = h.governor_adjustments;
+        img.hermite_forces = h.hermite_forces != 0;
+        img.ids.clear();
+        const auto column = [&](auto& vec, const Column c) {
+            vec.resize(n);
+            std::memcpy(static_cast<void*>(vec.data()), base + h.columns[c].offset,
+                        static_cast<std::size_t>(h.columns[c].size));
+        };
+        column(img.positions, kPosition);
+        column(img.prev_positions, kPrevPosition);
+        column(img.velocities, kVelocity);
+        column(img.accelerations, kAcceleration);
+        column(img.prev_accelerations, kPrevAcceleration);
+        column(img.masses, kMass);
+        column(img.pinned, kPinned);
+        column(img.tints, kTint);
+        column(img.flags, kFlags);
+        column(img.radii, kRadius);
+        column(img.densities, kDensity);
+        column(img.jerks, kJerk);
+        return true;
+    }
+
+    // Replace the world's bodies and Config with the image. Runs of bodies with the same optional components are
+    // bulk-created in captured order, so tables and iteration order come back as they were. created, if given,
+    // receives the new entities in image order.
+    static void restore(const flecs::world& w, const Image& img, std::vector<flecs::entity_t>* created = nullptr) {
+        clear_bodies(w);
+        w.set<Config>(img.config);
+        const std::size_t n = img.size();
+        if (created) created->clear();
+        for (std::size_t begin = 0; begin < n;) {
+            const std::uint8_t flags = img.flags[begin];
+            std::size_t end = begin + 1;
+            while (end < n && img.flags[end] == flags && end - begin < constants::bulk_spawn_chunk) ++end;
+
+            std::vector<ecs_id_t> ids{w.component<Position>().id(),     w.component<PrevPosition>().id(),
+                                      w.component<Velocity>().id(),     w.component<Acceleration>().id(),
+                                      w.component<PrevAcceleration>().id(), w.component<Mass>().id(),
+                                      w.component<Pinned>().id(),       w.component<Tint>().id()};
+            std::vector<void*> data{const_cast<Position*>(img.positions.data() + begin),
+                                    const_cast<PrevPosition*>(img.prev_positions.data() + begin),
+                                    const_cast<Velocity*>(img.velocities.data() + begin),
+                                    const_cast<Acceleration*>(img.accelerations.data() + begin),
+                                    const_cast<PrevAcceleration*>(img.prev_accelerations.data() + begin),
+                                    const_cast<Mass*>(img.masses.data() + begin),
+                                    const_cast<Pinned*>(img.pinned.data() + begin),
+                                    const_cast<Tint*>(img.tints.data() + begin)};
+            if (flags & kHasRadius) {
+                ids.push_back(w.component<Radius>().id());
+                data.push_back(const_cast<Radius*>(img.radii.data() + begin));
+            }
+            if (flags & kHasDensity) {
+                ids.push_back(w.component<Density>().id());
+                data.push_back(const_cast<Density*>(img.densities.data() + begin));
+            }
+            // Default-constructed: trail history is not part of the checkpoint.
+            for (const ecs_id_t id : {w.component<Trail>().id(), w.component<Selectable>().id(),
+                                      w.component<Draggable>().id()}) {
+                ids.push_back(id);
+                data.push_back(nullptr);
+            }
+            ecs_bulk_desc_t desc{};
+            desc.count = static_cast<int32_t>(end - begin);
+            std::copy(ids.begin(), ids.end(), desc.ids);
+            desc.data = data.data();
+            const ecs_entity_t* entities = ecs_bulk_init(w.c_ptr(), &desc);
+            if (created) created->insert(created->end(), entities, entities + (end - begin));
+            begin = end;
+        }
+    }
+
+private:
+    static constexpr std::array<std::size_t, kColumnCount> kStride{
+        sizeof(Position), sizeof(PrevPosition), sizeof(Velocity), sizeof(Acceleration), sizeof(PrevAcceleration),
+        sizeof(Mass),     sizeof(Pinned),       sizeof(Tint),     sizeof(std::uint8_t), sizeof(Radius),
+        sizeof(Density),  sizeof(DVec2)};
+    static constexpr std::uint64_t kFnvOffset = 0xcbf29ce484222325ULL;
+    static constexpr std::uint64_t kFnvPrime = 0x100000001b3ULL;
+    static constexpr std::array<char, kAlignment> kZeros{};
+
+    static_assert(std::is_trivially_copyable_v<Config>, "Config is checkpointed as raw bytes");
+
+    static std::uint64_t align(const std::uint64_t at) { return (at + kAlignment - 1) / kAlignment * kAlignment; }
+
+    static std::uint64_t fnv1a(std::uint64_t hash, const unsigned char* p, const std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) hash = (hash ^ p[i]) * kFnvPrime;
+        return hash;
+    }
+
+    static bool write_raw(std::FILE* out, const void* p, const std::size_t bytes) {
+        return bytes == 0 || std::fwrite(p, 1, bytes, out) == bytes;
+    }
+
+    // Make the data durable before the rename publishes it.
+    static bool sync_file(std::FILE* f) {
+#if !defined(_WIN32)
+        return ::fsync(::fileno(f)) == 0;
+#else
+        (void)f;
+        return true;
+#endif
+    }
+};
+
+}  // namespace nbody
@@ -16,27 +16,61 @@ struct Config {
     float max_speed = nbody::constants::default_max_speed;  // 0 = uncapped
     int bh_threshold = nbody::constants::default_bh_threshold;  // use Barnes-Hut above this entity count
     float bh_theta = nbody::constants::default_bh_theta;  // opening angle criterion
+    bool calibrate_bh_on_startup = true;  // measure (or load cached) direct/BH crossover into bh_threshold
 
     // Time & integrator
     bool paused = false;
-    bool use_fixed_dt = false;
-    float fixed_dt = nbody::constants::default_fixed_dt;
+    bool use_fixed_dt = true;  // fixed-step accumulator; off = one variable step per wall-clock tick
+    float fixed_dt = nbody::constants::default_fixed_dt;  // wall seconds per physics step (scaled by time_scale)
+    float step_budget_ms = nbody::constants::default_step_budget_ms;  // CPU time allowed to catch up per tick
+    bool interpolate_render = true;  // draw bodies between the last two physics states
     float time_scale = nbody::constants::default_time_scale;
-    int integrator = 1;  // 0 = Semi-Implicit Euler, 1 = Velocity Verlet
+    int integrator = 1;  // 0 = Semi-Implicit Euler, 1 = Velocity Verlet, 2 = Hermite (4th order, direct forces)
 
     // Stability controls
     float max_substep = nbody::constants::default_max_substep;          // seconds (cap per physics substep)
     int max_substeps_per_frame = nbody::constants::default_max_substeps;  // safety cap on CPU work
 
+    // Diagnostics: energy/momentum are O(N^2); compute them every N simulation steps
+    int diagnostics_interval = 1;
+
+    // Frame budget governor: trades accuracy for speed to hold governor_target_ms per step
+    bool governor_enabled = false;
+    float governor_target_ms = nbody::constants::default_governor_target_ms;
+    float governor_theta_min = nbody::constants::default_bh_theta;  // most accurate theta the governor may use
+    float governor_theta_max = nbody::constants::default_governor_theta_max;
+    int governor_substeps_min = 1;
+    int governor_substeps_max = nbody::constants::default_max_substeps;
+    int governor_diag_interval_max = nbody::constants::default_governor_diag_interval_max;
+
+    // Trajectory recording
+    int record_interval = nbody::constants::default_record_interval;  // simulation steps between recorded frames
+
+    // Crash-safe checkpoints (resume with --restart)
+    bool checkpoint_enabled = true;
+    float checkpoint_interval_s = nbody::constants::default_checkpoint_interval_s;  // wall seconds between saves
+
     // Visuals
     bool draw_trails = true;
     bool draw_velocity = true;
     bool draw_acceleration = false;
     int trail_max = nbody::constants::default_trail_max;
     float radius_scale = nbody::constants::default_radius_scale;  // visual size multiplier
+    bool body_lod = true;  // draw sub-pixel bodies as splats in large scenes
+    int lod_min_bodies = nbody::constants::default_lod_min_bodies;  // small scenes always draw full circles
+    float lod_subpixel_px = nbody::constants::default_lod_subpixel_px;  // true radius below this many pixels
+    float lod_splat_px = nbody::constants::default_lod_splat_px;  // on-screen size of a splat
+    bool tree_aggregate = true;  // when zoomed out, draw small Barnes-Hut cells as one glyph each
+    float aggregate_cell_px = nbody::constants::default_aggregate_cell_px;  // cells narrower than this aggregate
+    int render_mode = 0;  // 0 = auto (density view above density_auto_bodies), 1 = bodies, 2 = density
+    int density_auto_bodies = nbody::constants::default_density_auto_bodies;
+    int density_downsample = 1;  // screen pixels per density cell (each axis)
+    bool density_by_mass = true;  // accumulate mass per cell; off = body count
+    float density_exposure = nbody::constants::default_density_exposure;  // log tone-map gain for faint regions
 
     // UI/runtime
     double last_step_ms = 0.0;
+    double dropped_ms = 0.0;  // wall time discarded because catching up exceeded step_budget_ms
 
     // Add/Edit defaults and shortcuts
     // Defaults for adding bodies from UI or shortcut
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <raylib.h>
 
 namespace nbody::constants {
@@ -30,13 +32,34 @@ inline constexpr float acc_vector_scale = 500.0F;
 inline constexpr float min_body_radius = 6.0F;
 inline constexpr float default_radius_scale = 1.0F;  // visual size multiplier for body radii
 inline constexpr float selected_circle_alpha = 0.5F;
+inline constexpr int body_texture_size = 64;  // px; circle sprite used for batched body quads
+inline constexpr std::size_t body_batch_quads = 2048;  // bodies per rlgl batch chunk (well under the batch limit)
+inline constexpr std::size_t trail_batch_segments = 8192;  // trail segments per rlgl batch chunk
+inline constexpr int default_lod_min_bodies = 1000;
+inline constexpr float default_lod_subpixel_px = 0.5F;
+inline constexpr float default_lod_splat_px = 2.0F;
+inline constexpr float lod_splat_px_max = 8.0F;
+inline constexpr float default_aggregate_cell_px = 4.0F;
+inline constexpr float aggregate_cell_px_max = 32.0F;
+
+// Density view
+inline constexpr int default_density_auto_bodies = 50000;
+inline constexpr int density_downsample_max = 8;
+inline constexpr float default_density_exposure = 1000.0F;
+inline constexpr float density_exposure_min = 1.0F;
+inline constexpr float density_exposure_max = 1.0e6F;
+inline constexpr std::size_t density_min_bodies_per_chunk = 16384;
+inline constexpr std::size_t density_min_rows_per_chunk = 32;
+inline constexpr ::Color density_low{20, 30, 90, 255};
+inline constexpr ::Color density_mid{230, 120, 40, 255};
+inline constexpr ::Color density_high{255, 250, 235, 255};
 
 inline constexpr double body_density = 5510.0;  // kg/m^3, approx. Earth average
 inline constexpr float radius_scale_min = 0.1F;
 inline constexpr float radius_scale_max = 100.0F;
-inline constexpr float grid_spacing = 1.0e7F;
-inline constexpr float grid_axis_epsilon = 1e-4F;
-inline constexpr float grid_steps_epsilon = 1e-6F;
+inline constexpr float grid_min_px = 16.0F;  // minor grid lines are at least this far apart on screen
+inline constexpr long long grid_major_every = 10;  // every Nth minor line is major
+inline constexpr int grid_minor_alpha = 160;
 inline constexpr ::Color grid_color{40, 40, 40, 255};
 inline constexpr ::Color axis_color{80, 80, 80, 255};
 
@@ -44,12 +67,27 @@ inline constexpr int trail_alpha_min = 20;
 inline constexpr int trail_alpha_max = 250;
 inline constexpr float trail_alpha_range = 230.0F;
 
+inline constexpr std::size_t bulk_spawn_chunk = std::size_t{1} << 20;  // bodies per flecs bulk_init call
+
 inline constexpr double seed_small_mass = 7.342e22;  // kg (Moon mass)
 inline constexpr double seed_central_mass = 5.972e24;  // kg (Earth mass)
 inline constexpr double seed_center_x = 0.0;
 inline constexpr double seed_center_y = 0.0;
 inline constexpr double seed_offset_x = 3.844e8;  // m (Earth-Moon distance)
 
+// Procedural initial conditions (see Generators.hpp)
+inline constexpr int default_generator_bodies = 10000;
+inline constexpr int generator_bodies_max = 5000000;
+inline constexpr double generator_total_mass = 1.0e25;  // kg
+inline constexpr double generator_scale_radius = 4.0e8;  // m; Plummer radius, disk scale length, collapse radius
+inline constexpr double generator_plummer_cutoff = 10.0;  // Plummer radii; farther samples are redrawn
+inline constexpr double generator_central_fraction = 0.5;  // disks: share of the mass in the central body
+inline constexpr double generator_disk_inner = 0.2;  // disks: inner edge in scale lengths
+inline constexpr double generator_disk_outer = 6.0;  // disks: outer edge in scale lengths
+inline constexpr double generator_collision_separation = 8.0;  // colliding disks: start distance, scale lengths
+inline constexpr double generator_collision_impact = 2.0;  // colliding disks: impact parameter, scale lengths
+inline constexpr std::size_t generator_min_bodies_per_chunk = 16384;
+
 inline constexpr float zoom_wheel_scale = 0.1F;
 // Camera zoom bounds aligned with meter-to-pixel display scale (~1e-6)
 inline constexpr float min_zoom = 1e-9F;
@@ -66,6 +104,7 @@ inline constexpr float softening_max = 1e9F;
 inline constexpr float velocity_cap_min = 0.0F;
 inline constexpr float velocity_cap_max = 1e6F;
 inline constexpr int trail_length_max = 2000;
+inline constexpr int bh_threshold_max = 20000;
 
 inline constexpr float spawn_mass_min = 1e20F;
 inline constexpr float spawn_mass_max = 1e28F;
@@ -98,4 +137,53 @@ inline constexpr unsigned char alpha_opaque = 255;  // fully opaque
 // Make substepping opt-in by default: a huge cap yields 1 substep for typical dt
 inline constexpr float default_max_substep = 1.0e9F;         // seconds
 inline constexpr int default_max_substeps = 200;             // at most 200 substeps per frame
+
+// Simulation thread pacing
+inline constexpr float sim_max_wall_dt = 0.25F;  // seconds; clamps dt after stalls (e.g. window drag)
+inline constexpr int sim_idle_sleep_ms = 2;  // sleep between snapshot publishes while paused
+inline constexpr float default_step_budget_ms = 8.0F;  // CPU time per tick for fixed-step catch-up
+inline constexpr float step_budget_ms_min = 1.0F;
+inline constexpr float step_budget_ms_max = 100.0F;
+
+// Frame budget governor
+inline constexpr float default_governor_target_ms = 8.0F;
+inline constexpr float default_governor_theta_max = 1.2F;
+inline constexpr int default_governor_diag_interval_max = 64;
+inline constexpr float governor_target_ms_min = 1.0F;
+inline constexpr float governor_target_ms_max = 100.0F;
+inline constexpr float governor_theta_limit = 2.0F;  // UI bound for theta sliders
+inline constexpr int diagnostics_interval_max = 1024;
+inline constexpr double governor_ema_weight = 0.2;  // weight of the newest step time in the moving average
+inline constexpr double governor_over_ratio = 1.1;  // degrade above target * ratio
+inline constexpr double governor_under_ratio = 0.6;  // restore below target * ratio
+inline constexpr int governor_cooldown_steps = 10;  // steps to settle between adjustments
+inline constexpr float governor_theta_factor = 1.15F;
+
+// Trajectory recording
+inline constexpr int default_record_interval = 10;  // steps
+inline constexpr int record_interval_max = 10000;
+inline constexpr std::size_t record_chunk_bytes = std::size_t{32} << 20;  // raw bytes per compressed chunk
+inline constexpr std::size_t record_frames_per_chunk_max = 64;
+inline constexpr std::uint32_t record_keyframe_chunks = 8;  // chunks per keyframe; the rest delta across chunks
+inline constexpr std::size_t record_queue_depth = 4;  // frame buffers in flight before samples are dropped
+inline constexpr float default_playback_fps = 30.0F;  // recorded frames shown per second
+inline constexpr float playback_fps_max = 1000.0F;
+
+// Checkpoints
+inline constexpr float default_checkpoint_interval_s = 300.0F;
+inline constexpr float checkpoint_interval_s_min = 10.0F;
+inline constexpr float checkpoint_interval_s_max = 86400.0F;
+
+// Profiler
+inline constexpr std::size_t profiler_history_frames = 600;  // frames kept for the timeline and statistics
+inline constexpr int default_profiler_window = 240;  // frames summarised by min/avg/p99
+inline constexpr float profiler_timeline_height = 90.0F;  // px
+inline constexpr std::size_t trace_max_events = std::size_t{1} << 19;  // zones kept per capture (~16 MiB)
+inline constexpr std::size_t profiler_max_threads = 256;  // named threads in a trace
+inline constexpr int default_trace_frames = 120;
+inline constexpr int trace_frames_max = 3600;
+inline constexpr int default_alloc_check_frames = 600;  // checked frames in --alloc-check mode
+inline constexpr int alloc_check_warmup_frames = 300;  // frames for scratch buffers to reach steady state first
+inline constexpr int alloc_check_frames_max = 1000000;
+inline constexpr int alloc_check_max_reports = 20;  // offending stage/frame pairs logged individually
 }  // namespace nbody::constants
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <flecs.h>
+#include <numbers>
+#include <optional>
+#include <string_view>
+
+#include "Config.hpp"
+#include "Constants.hpp"
+#include "Parallel.hpp"
+#include "Scenario.hpp"
+
+namespace nbody {
+
+// Procedural initial conditions for large, reproducible workloads.
+// - Each body draws from its own counter-based random stream keyed by (seed, body index), so a given
+//   kind/count/seed produces bit-identical bodies however many threads generate them.
+// - The models are the usual 3D profiles laid onto the simulation plane, so they start close to, not exactly in,
+//   equilibrium under the in-plane 1/r^2 force.
+// - Output is shifted to the centre-of-mass frame (zero net momentum).
+class Generators {
+public:
+    enum class Kind : std::uint8_t { Plummer, ExponentialDisk, ColdCollapse, CollidingDisks };
+    static constexpr std::array kKinds = {Kind::Plummer, Kind::ExponentialDisk, Kind::ColdCollapse,
+                                          Kind::CollidingDisks};
+
+    struct Params {
+        Kind kind = Kind::Plummer;
+        std::size_t count = static_cast<std::size_t>(constants::default_generator_bodies);
+        std::uint64_t seed = 1;
+        double total_mass = constants::generator_total_mass;  // kg
+        double scale_radius = constants::generator_scale_radius;  // m
+        bool set_softening = true;  // apply(): also set Config::softening to suggested_softening()
+    };
+
+    // Command-line name ("plummer", "disk", "collapse", "collide").
+    [[nodiscard]] static auto name(const Kind kind) -> const char* {
+        switch (kind) {
+            case Kind::Plummer: return "plummer";
+            case Kind::ExponentialDisk: return "disk";
+            case Kind::ColdCollapse: return "collapse";
+            case Kind::CollidingDisks: return "collide";
+        }
+        return "";
+    }
+    [[nodiscard]] static auto label(const Kind kind) -> const char* {
+        switch (kind) {
+            case Kind::Plummer: return "Plummer sphere";
+            case Kind::ExponentialDisk: return "Exponential disk";
+            case Kind::ColdCollapse: return "Cold collapse";
+            case Kind::CollidingDisks: return "Colliding disks";
+        }
+        return "";
+    }
+    [[nodiscard]] static auto parse(const std::string_view text) -> std::optional<Kind> {
+        for (const Kind k : kKinds) {
+            if (text == name(k)) return k;
+        }
+        return std::nullopt;
+    }
+
+    // About half the mean interparticle spacing inside the scale radius.
+    [[nodiscard]] static auto suggested_softening(const Params& p) -> double {
+        return 0.5 * p.scale_radius / std::sqrt(static_cast<double>(std::max<std::size_t>(1, p.count)));
+    }
+
+    [[nodiscard]] static auto generate(const Params& p, const double G) -> BodyBuffers {
+        BodyBuffers out;
+        out.resize(p.count);
+        Parallel::for_chunks(p.count, constants::generator_min_bodies_per_chunk,
+                             [&](std::size_t, const std::size_t b, const std::size_t e) {
+                                 for (std::size_t i = b; i < e; ++i) {
+                                     Stream rng(p.seed, i);
+                                     const Body body = sample(p, G, i, rng);
+                                     out.positions[i] = body.pos;
+                                     out.velocities[i] = body.vel;
+                                     out.masses[i] = static_cast<float>(body.mass);
+                                     out.tints[i] = body.tint;
+                                 }
+                             });
+        to_center_of_mass_frame(out);
+        return out;
+    }
+
+    // Replace the world's bodies with generated ones.
+    static void apply(const flecs::world& w, const Params& p) {
+        auto* cfg = w.get_mut<Config>();
+        if (!cfg) return;
+        if (p.set_softening) cfg->softening = static_cast<float>(suggested_softening(p));
+        const BodyBuffers bodies = generate(p, cfg->g);
+        assign_bodies(w, bodies.columns());
+    }
+
+private:
+    struct Body {
+        DVec2 pos;
+        DVec2 vel;
+        double mass = 0.0;
+        raylib::Color tint{WHITE};
+    };
+
+    // Counter-based random stream: draw k of stream (seed, index) is a splitmix64 hash of both, so no state is
+    // shared between bodies or threads.
+    class Stream {
+    public:
+        Stream(const std::uint64_t seed, const std::uint64_t index) : key_(mix(mix(seed) + index * kGolden)) {}
+
+        auto uniform() -> double { return static_cast<double>(next() >> 11) * 0x1.0p-53; }  // [0, 1)
+        auto open_uniform() -> double { return (static_cast<double>(next() >> 11) + 0.5) * 0x1.0p-53; }  // (0, 1)
+        auto direction() -> DVec2 {
+            const double a = 2.0 * std::numbers::pi * uniform();
+            return DVec2{std::cos(a), std::sin(a)};
+        }
+        auto color() -> raylib::Color {
+            constexpr int span = constants::random_color_max - constants::random_color_min + 1;
+            const std::uint64_t bits = next();
+            const auto channel = [&](const int shift) {
+                return static_cast<unsigned char>(constants::random_color_min +
+                                                  static_cast<int>((bits >> shift) % span));
+            };
+            return raylib::Color(channel(0), channel(16), channel(32), constants::alpha_opaque);
+        }
+
+    private:
+        static constexpr std::uint64_t kGolden = 0x9E3779B97F4A7C15ULL;
+        std::uint64_t key_;
+        std::uint64_t counter_ = 0;
+
+        auto next() -> std::uint64_t { return mix(key_ + ++counter_ * kGolden); }
+        static auto mix(std::uint64_t z) -> std::uint64_t {
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+    };
+
+    static auto sample(const Params& p, const double G, const std::size_t i, Stream& rng) -> Body {
+        const double n = static_cast<double>(p.count);
+        switch (p.kind) {
+            case Kind::Plummer: return plummer(G, p.total_mass, p.scale_radius, p.total_mass / n, rng);
+            case Kind::ExponentialDisk: return disk(G, p.total_mass, p.scale_radius, i, p.count, 1.0, rng);
+            case Kind::ColdCollapse: {
+                // Uniform disc at rest
+                const double r = p.scale_radius * std::sqrt(rng.uniform());
+                return Body{rng.direction() * r, DVec2{}, p.total_mass / n, rng.color()};
+            }
+            case Kind::CollidingDisks: {
+                // Two half-mass disks on a bound approach, the second one counter-rotating
+                const std::size_t first = p.count - p.count / 2;
+                const bool second = i >= first;
+                Body b = second ? disk(G, 0.5 * p.total_mass, p.scale_radius, i - first, p.count / 2, -1.0, rng)
+                                : disk(G, 0.5 * p.total_mass, p.scale_radius, i, first, 1.0, rng);
+                const double side = second ? 1.0 : -1.0;
+                const double separation = constants::generator_collision_separation * p.scale_radius;
+                const double speed = 0.5 * std::sqrt(G * p.total_mass / separation);
+                b.pos += DVec2{0.5 * separation * side,
+                               0.5 * constants::generator_collision_impact * p.scale_radius * side};
+                b.vel += DVec2{-speed * side, 0.0};
+                return b;
+            }
+        }
+        return Body{};
+    }
+
+    // Plummer model sampled after Aarseth, Henon & Wielen (1974): radius from the cumulative mass profile, speed by
+    // rejection from the isotropic distribution function.
+    static auto plummer(const double G, const double M, const double a, const double mass, Stream& rng) -> Body {
+        double r = 0.0;
+        do {
+            r = a / std::sqrt(std::pow(rng.open_uniform(), -2.0 / 3.0) - 1.0);
+        } while (r > constants::generator_plummer_cutoff * a);
+        double q = 0.0;
+        do {
+            q = rng.uniform();
+        } while (0.1 * rng.uniform() > q * q * std::pow(1.0 - q * q, 3.5));
+        const double escape = std::sqrt(2.0 * G * M / a) * std::pow(1.0 + (r * r) / (a * a), -0.25);
+        return Body{rng.direction() * r, rng.direction() * (q * escape), mass, rng.color()};
+    }
+
+    // Body j of an exponential disk of n bodies: j == 0 is the central mass, the rest follow a surface density
+    // ~ exp(-R / Rd) on circular orbits around the mass enclosed (spin +1 counter-clockwise, -1 clockwise).
+    static auto disk(const double G, const double M, const double Rd, const std::size_t j, const std::size_t n,
+                     const double spin, Stream& rng) -> Body {
+        const double central = n > 1 ? constants::generator_central_fraction * M : M;
+        if (j == 0) return Body{DVec2{}, DVec2{}, central, GOLD};
+        const double diskMass = M - central;
+        const double inner = constants::generator_disk_inner;
+        const double outer = constants::generator_disk_outer;
+        double x = 0.0;
+        do {
+            x = -std::log(rng.open_uniform() * rng.open_uniform());  // Gamma(2): R e^-R in units of Rd
+        } while (x < inner || x > outer);
+        const auto enclosed = [](const double y) { return 1.0 - (1.0 + y) * std::exp(-y); };
+        const double fraction = (enclosed(x) - enclosed(inner)) / (enclosed(outer) - enclosed(inner));
+        const double R = x * Rd;
+        const double speed = std::sqrt(G * (central + diskMass * fraction) / R);
+        const DVec2 radial = rng.direction();
+        const DVec2 tangent{-radial.y * spin, radial.x * spin};
+        return Body{radial * R, tangent * speed, diskMass / static_cast<double>(n - 1), rng.color()};
+    }
+
+    // Serial on purpose: a fixed summation order keeps the result independent of the thread count.
+    static void to_center_of_mass_frame(BodyBuffers& out) {
+        double M = 0.0;
+        DVec2 com{};
+        DVec2 momentum{};
+        for (std::size_t i = 0; i < out.size(); ++i) {
+            const double m = out.masses[i];
+            M += m;
+            com += out.positions[i] * m;
+            momentum += out.velocities[i] * m;
+        }
+        if (M <= 0.0) return;
+        com *= 1.0 / M;
+        momentum *= 1.0 / M;
+        Parallel::for_chunks(out.size(), constants::generator_min_bodies_per_chunk,
+                             [&](std::size_t, const std::size_t b, const std::size_t e) {
+                                 for (std::size_t i = b; i < e; ++i) {
+                                     out.positions[i] -= com;
+                                     out.velocities[i] -= momentum;
+                                 }
+                             });
+    }
+};
+
+}  // namespace nbody
@@ -0,0 +1,311 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <flecs.h>
+#include <numbers>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "Constants.hpp"
+#include "MappedFile.hpp"
+#include "Parallel.hpp"
+#include "Scenario.hpp"
+
+namespace nbody {
+
+// Initial conditions from external tools.
+//
+// CSV (.csv, .txt): one body per line, "x,y,vx,vy,m[,radius][,color]" in SI units. Blank lines, '#' comments and
+// a leading header line are skipped; an empty radius means "derive from mass", color is #RRGGBB[AA], 0xRRGGBBAA
+// or a decimal RGBA integer.
+// Binary (any other extension): packed little-endian records of f64 x, y, vx, vy, m, then f64 radius when
+// BinaryLayout::radius is set and u32 RGBA (R in the low byte) when BinaryLayout::color is set.
+//
+// Both formats are parsed in parallel chunks straight from a memory mapping, then handed to assign_bodies()
+// (entities reused in place, the rest bulk-created).
+class Importer {
+public:
+    struct BinaryLayout {
+        bool radius = false;
+        bool color = false;
+    };
+
+    // Bodies read from the file; radii is empty unless the input had a radius column.
+    struct Result : BodyBuffers {
+        std::string error;  // empty on success
+    };
+
+    [[nodiscard]] static auto is_csv(const std::filesystem::path& path) -> bool {
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](const unsigned char c) { return std::tolower(c); });
+        return ext == ".csv" || ext == ".txt";
+    }
+
+    static Result read(const std::filesystem::path& path) { return read(path, BinaryLayout{}); }
+    static Result read(const std::filesystem::path& path, const BinaryLayout layout) {
+        Result r;
+        MappedFile file;
+        if (!file.open(path)) {
+            r.error = "cannot open " + path.string();
+            return r;
+        }
+        file.will_need(0, file.size());
+        if (is_csv(path)) {
+            read_csv(reinterpret_cast<const char*>(file.data()), file.size(), r);
+        } else {
+            read_binary(file.data(), file.size(), layout, r);
+        }
+        return r;
+    }
+
+    // Replace the world's bodies with an import result.
+    static void apply(const flecs::world& w, const Result& r) {
+        assign_bodies(w, r.columns());
+    }
+
+private:
+    static constexpr std::size_t kMinCsvBytesPerChunk = std::size_t{1} << 20;
+    static constexpr std::size_t kMinRecordsPerChunk = 1 << 16;
+
+    // Per-chunk parse output, concatenated in chunk order afterwards.
+    struct Part {
+        BodyBuffers rows;
+        bool any_radius = false;
+        std::size_t first_bad_line = 0;  // 1-based within the chunk, 0 = none
+        std::size_t lines = 0;
+    };
+
+    static void read_csv(const char* data, const std::size_t size, Result& out) {
+        // Skip a UTF-8 BOM and a header line (first line that does not start like a number).
+        std::size_t begin = 0;
+        if (size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0) begin = 3;
+        const std::size_t firstEnd = line_end(data, size, begin);
+        const std::string_view first = trim({data + begin, firstEnd - begin});
+        if (!first.empty() && first.front() != '#' && !starts_number(first)) begin = std::min(size, firstEnd + 1);
+
+        const std::size_t body = size - begin;
+        std::vector<Part> parts(Parallel::chunk_count(body, kMinCsvBytesPerChunk));
+        Parallel::for_chunks(body, kMinCsvBytesPerChunk, [&](const std::size_t c, std::size_t b, std::size_t e) {
+            // Chunks own the lines that start inside them.
+            b += begin;
+            e += begin;
+            if (b > begin && data[b - 1] != '\n') b = line_end(data, size, b) + 1;
+            if (b >= e) return;
+            if (data[e - 1] != '\n') e = std::min(size, line_end(data, size, e) + 1);
+            parse_lines(data, b, e, parts[c]);
+        });
+
+        // Report the first bad line with its absolute line number.
+        std::size_t linesBefore = begin > 0 && data[begin - 1] == '\n' ? 1 : 0;
+        for (const Part& p : parts) {
+            if (p.first_bad_line != 0) {
+                out.error = "line " + std::to_string(linesBefore + p.first_bad_line) +
+                    ": expected x,y,vx,vy,m[,radius][,color] with a finite, non-negative mass";
+                return;
+            }
+            linesBefore += p.lines;
+        }
+        merge(parts, out);
+    }
+
+    static void parse_lines(const char* data, std::size_t at, const std::size_t end, Part& part) {
+        BodyBuffers& rows = part.rows;
+        while (at < end) {
+            const std::size_t eol = line_end(data, end, at);
+            const std::size_t lineStart = at;
+            ++part.lines;
+            std::string_view line = trim({data + at, eol - at});
+            at = eol + 1;
+            if (line.empty() || line.front() == '#') continue;
+
+            double v[5] = {};
+            for (int k = 0; k < 5; ++k) {
+                if (!next_double(line, v[k]) || (k < 4 && !next_separator(line))) {
+                    part.first_bad_line = part.lines;
+                    return;
+                }
+            }
+            double radius = 0.0;
+            raylib::Color tint = color_for(lineStart);
+            if (next_separator(line)) {
+                if (!line.empty() && line.front() != ',') {
+                    if (!next_double(line, radius)) {
+                        part.first_bad_line = part.lines;
+                        return;
+                    }
+                    part.any_radius = true;
+                }
+                if (next_separator(line) && !next_color(line, tint)) {
+                    part.first_bad_line = part.lines;
+                    return;
+                }
+            }
+            if (!trim(line).empty() || !std::isfinite(v[4]) || v[4] < 0.0) {
+                part.first_bad_line = part.lines;
+                return;
+            }
+            rows.positions.push_back(DVec2{v[0], v[1]});
+            rows.velocities.push_back(DVec2{v[2], v[3]});
+            rows.masses.push_back(static_cast<float>(v[4]));
+            rows.radii.push_back(radius);
+            rows.tints.push_back(tint);
+        }
+    }
+
+    static void read_binary(const std::byte* data, const std::size_t size, const BinaryLayout layout, Result& out) {
+        const std::size_t record =
+            5 * sizeof(double) + (layout.radius ? sizeof(double) : 0) + (layout.color ? sizeof(std::uint32_t) : 0);
+        if (size % record != 0) {
+            out.error = "file size is not a multiple of the " + std::to_string(record) + "-byte record";
+            return;
+        }
+        const std::size_t n = size / record;
+        out.resize(n);
+        if (layout.radius) out.radii.resize(n);
+        std::vector<std::size_t> bad(Parallel::chunk_count(n, kMinRecordsPerChunk), n);
+        Parallel::for_chunks(n, kMinRecordsPerChunk, [&](const std::size_t c, const std::size_t b,
+                                                         const std::size_t e) {
+            for (std::size_t i = b; i < e; ++i) {
+                const std::byte* p = data + i * record;
+                double v[6] = {};
+                std::memcpy(v, p, (layout.radius ? 6 : 5) * sizeof(double));
+                if (!std::isfinite(v[4]) || v[4] < 0.0) {
+                    bad[c] = std::min(bad[c], i);
+                    continue;
+                }
+                out.positions[i] = DVec2{v[0], v[1]};
+                out.velocities[i] = DVec2{v[2], v[3]};
+                out.masses[i] = static_cast<float>(v[4]);
+                if (layout.radius) out.radii[i] = v[5] > 0.0 ? v[5] : radius_for_mass(v[4]);
+                if (layout.color) {
+                    std::uint32_t rgba = 0;
+                    std::memcpy(&rgba, p + record - sizeof(rgba), sizeof(rgba));
+                    out.tints[i] =
+                        raylib::Color(static_cast<unsigned char>(rgba), static_cast<unsigned char>(rgba >> 8),
+                                      static_cast<unsigned char>(rgba >> 16), static_cast<unsigned char>(rgba >> 24));
+                } else {
+                    out.tints[i] = color_for(i);
+                }
+            }
+        });
+        if (const std::size_t first = *std::min_element(bad.begin(), bad.end()); first < n) {
+            out = Result{};
+            out.error = "record " + std::to_string(first) + ": mass must be finite and non-negative";
+        }
+    }
+
+    // Concatenate chunk results in parallel; radii are kept only if some row had one.
+    static void merge(std::vector<Part>& parts, Result& out) {
+        std::vector<std::size_t> offsets(parts.size() + 1, 0);
+        bool anyRadius = false;
+        for (std::size_t c = 0; c < parts.size(); ++c) {
+            offsets[c + 1] = offsets[c] + parts[c].rows.size();
+            anyRadius = anyRadius || parts[c].any_radius;
+        }
+        const std::size_t n = offsets.back();
+        out.resize(n);
+        if (anyRadius) out.radii.resize(n);
+        Parallel::for_chunks(parts.size(), 1, [&](std::size_t, const std::size_t b, const std::size_t e) {
+            for (std::size_t c = b; c < e; ++c) {
+                const BodyBuffers& rows = parts[c].rows;
+                const std::size_t at = offsets[c];
+                std::copy(rows.positions.begin(), rows.positions.end(), out.positions.data() + at);
+                std::copy(rows.velocities.begin(), rows.velocities.end(), out.velocities.data() + at);
+                std::copy(rows.masses.begin(), rows.masses.end(), out.masses.data() + at);
+                std::copy(rows.tints.begin(), rows.tints.end(), out.tints.data() + at);
+                if (!anyRadius) continue;
+                for (std::size_t i = 0; i < rows.size(); ++i) {
+                    out.radii[at + i] = rows.radii[i] > 0.0 ? rows.radii[i] : radius_for_mass(rows.masses[i]);
+                }
+            }
+        });
+    }
+
+    static std::size_t line_end(const char* data, const std::size_t end, const std::size_t at) {
+        const void* nl = std::memchr(data + at, '\n', end - at);
+        return nl ? static_cast<std::size_t>(static_cast<const char*>(nl) - data) : end;
+    }
+
+    static std::string_view trim(std::string_view s) {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+        return s;
+    }
+
+    static bool starts_number(const std::string_view s) {
+        const char c = s.front();
+        return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.';
+    }
+
+    static bool next_double(std::string_view& s, double& v) {
+        s = trim(s);
+        if (!s.empty() && s.front() == '+') s.remove_prefix(1);
+        const auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), v);
+        if (ec != std::errc{}) return false;
+        s.remove_prefix(static_cast<std::size_t>(ptr - s.data()));
+        return true;
+    }
+
+    static bool next_separator(std::string_view& s) {
+        s = trim(s);
+        if (s.empty() || s.front() != ',') return false;
+        s.remove_prefix(1);
+        s = trim(s);
+        return true;
+    }
+
+    static bool next_color(std::string_view& s, raylib::Color& out) {
+        s = trim(s);
+        std::uint32_t v = 0;
+        int base = 10;
+        bool hex = false;
+        if (!s.empty() && s.front() == '#') {
+            s.remove_prefix(1);
+            hex = true;
+        } else if (s.size() > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+            s.remove_prefix(2);
+            hex = true;
+        }
+        if (hex) base = 16;
+        const char* start = s.data();
+        const auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), v, base);
+        if (ec != std::errc{}) return false;
+        const auto digits = static_cast<std::size_t>(ptr - start);
+        s.remove_prefix(digits);
+        if (hex && digits == 6) v = (v << 8) | 0xFFU;  // #RRGGBB: opaque
+        if (hex) {
+            out = raylib::Color(static_cast<unsigned char>(v >> 24), static_cast<unsigned char>(v >> 16),
+                                static_cast<unsigned char>(v >> 8), static_cast<unsigned char>(v));
+        } else {
+            out = raylib::Color(static_cast<unsigned char>(v), static_cast<unsigned char>(v >> 8),
+                                static_cast<unsigned char>(v >> 16), static_cast<unsigned char>(v >> 24));
+        }
+        return true;
+    }
+
+    // Deterministic stand-in for random_nice_color(), safe to call from worker threads.
+    static raylib::Color color_for(std::uint64_t i) {
+        i = (i + 0x9E3779B97F4A7C15ULL) * 0xBF58476D1CE4E5B9ULL;
+        i ^= i >> 31;
+        constexpr int span = constants::random_color_max - constants::random_color_min + 1;
+        const auto channel = [&](const int shift) {
+            return static_cast<unsigned char>(constants::random_color_min + static_cast<int>((i >> shift) % span));
+        };
+        return raylib::Color(channel(0), channel(16), channel(32), constants::alpha_opaque);
+    }
+
+    static double radius_for_mass(const double mass) {
+        return std::cbrt((3.0 * std::max(1.0, mass)) / (4.0 * std::numbers::pi * constants::body_density));
+    }
+};
+
+}  // namespace nbody
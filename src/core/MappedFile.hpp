@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+#include <vector>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nbody {
+
+// Read-only view of a whole file. On POSIX the file is memory-mapped, so opening costs O(1) and pages are
+// faulted in on first touch; elsewhere it falls back to reading the file into memory.
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::filesystem::path& path) { open(path); }
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            data_ = other.data_;
+            size_ = other.size_;
+            mapped_ = other.mapped_;
+            fallback_ = std::move(other.fallback_);
+            other.data_ = nullptr;
+            other.size_ = 0;
+            other.mapped_ = false;
+        }
+        return *this;
+    }
+
+    bool open(const std::filesystem::path& path) {
+        close();
+#if !defined(_WIN32)
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st {};
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        void* p = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);  // the mapping keeps its own reference
+        if (p == MAP_FAILED) return false;
+        data_ = static_cast<const std::byte*>(p);
+        size_ = static_cast<std::size_t>(st.st_size);
+        mapped_ = true;
+        return true;
+#else
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) return false;
+        const auto end = in.tellg();
+        if (end <= 0) return false;
+        fallback_.resize(static_cast<std::size_t>(end));
+        in.seekg(0);
+        if (!in.read(reinterpret_cast<char*>(fallback_.data()), static_cast<std::streamsize>(fallback_.size()))) {
+            fallback_.clear();
+            return false;
+        }
+        data_ = fallback_.data();
+        size_ = fallback_.size();
+        return true;
+#endif
+    }
+
+    void close() {
+#if !defined(_WIN32)
+        if (mapped_ && data_) ::munmap(const_cast<std::byte*>(data_), size_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+        mapped_ = false;
+        fallback_.clear();
+    }
+
+    [[nodiscard]] auto data() const -> const std::byte* { return data_; }
+    [[nodiscard]] auto size() const -> std::size_t { return size_; }
+    [[nodiscard]] auto is_open() const -> bool { return data_ != nullptr; }
+
+    // Hint that [offset, offset + length) will be read sequentially soon (no-op where unsupported).
+    void will_need(const std::size_t offset, const std::size_t length) const {
+#if !defined(_WIN32)
+        if (!mapped_ || offset >= size_) return;
+        const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        const std::size_t start = offset / page * page;
+        ::madvise(const_cast<std::byte*>(data_) + start, std::min(size_ - start, length + (offset - start)),
+                  MADV_WILLNEED);
+#else
+        (void)offset;
+        (void)length;
+#endif
+    }
+
+private:
+    const std::byte* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<std::byte> fallback_;
+};
+
+}  // namespace nbody
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Profiler.hpp"
+
+namespace nbody {
+
+// Minimal fork-join helper for data-parallel loops over index ranges.
+// [0, count) is split into contiguous chunks, at most one per hardware thread and none smaller than minChunk;
+// fn(chunk, begin, end) runs once per chunk, with the calling thread taking chunk 0. Chunks run on a persistent
+// worker pool, so a call makes no heap allocations and spawns no threads. Ranges that fit in one chunk, calls
+// from inside a chunk, and calls made while another thread holds the pool all run inline on the caller.
+class Parallel {
+public:
+    [[nodiscard]] static auto workers() -> std::size_t {
+        return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    // Number of chunks for_chunks() will use, so callers can size per-chunk scratch up front.
+    [[nodiscard]] static auto chunk_count(const std::size_t count, const std::size_t minChunk) -> std::size_t {
+        if (count == 0) return 1;
+        const std::size_t grain = std::max<std::size_t>(1, minChunk);
+        return std::clamp<std::size_t>((count + grain - 1) / grain, 1, workers());
+    }
+
+    template <typename F>
+    static void for_chunks(const std::size_t count, const std::size_t minChunk, F&& fn) {
+        const std::size_t chunks = chunk_count(count, minChunk);
+        const std::size_t per = (count + chunks - 1) / chunks;
+        auto body = [&](const std::size_t c) {
+            Profiler::Zone zone("Parallel chunk");
+            fn(c, std::min(count, c * per), std::min(count, (c + 1) * per));
+        };
+        const auto inline_all = [&] {
+            for (std::size_t c = 0; c < chunks; ++c) body(c);
+        };
+        if (chunks == 1 || t_in_worker) {
+            inline_all();
+            return;
+        }
+        Pool& pool = Pool::instance();
+        std::unique_lock job(pool.job_mutex, std::try_to_lock);
+        if (!job.owns_lock()) {
+            inline_all();
+            return;
+        }
+        pool.dispatch(chunks, [](void* ctx, const std::size_t c) { (*static_cast<decltype(body)*>(ctx))(c); }, &body);
+    }
+
+private:
+    static inline thread_local bool t_in_worker = false;
+
+    // workers() - 1 threads parked on a condition variable; worker t runs chunk t + 1 of each job.
+    struct Pool {
+        using Task = void (*)(void*, std::size_t);
+
+        std::mutex job_mutex;  // one job at a time
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        Task task = nullptr;
+        void* context = nullptr;
+        std::size_t chunks = 0;
+        std::size_t pending = 0;
+        std::uint64_t generation = 0;
+        bool stopping = false;
+        std::vector<std::jthread> threads;  // last: joined before the members above are destroyed
+
+        static auto instance() -> Pool& {
+            static Pool pool;
+            return pool;
+        }
+
+        Pool() {
+            const std::size_t n = workers() - 1;
+            threads.reserve(n);
+            for (std::size_t t = 0; t < n; ++t) threads.emplace_back([this, t] { work(t); });
+        }
+
+        ~Pool() {
+            {
+                std::scoped_lock lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+        }
+
+        Pool(const Pool&) = delete;
+        Pool& operator=(const Pool&) = delete;
+
+        void dispatch(const std::size_t n, const Task fn, void* ctx) {
+            {
+                std::scoped_lock lock(mutex);
+                task = fn;
+                context = ctx;
+                chunks = n;
+                pending = n - 1;
+                ++generation;
+            }
+            wake.notify_all();
+            fn(ctx, 0);
+            std::unique_lock lock(mutex);
+            done.wait(lock, [this] { return pending == 0; });
+        }
+
+        void work(const std::size_t t) {
+            t_in_worker = true;
+            std::array<char, 32> name{};
+            std::snprintf(name.data(), name.size(), "Worker %zu", t + 1);
+            Profiler::name_thread(name.data());
+            std::uint64_t seen = 0;
+            while (true) {
+                Task fn = nullptr;
+                void* ctx = nullptr;
+                std::size_t n = 0;
+                {
+                    std::unique_lock lock(mutex);
+                    wake.wait(lock, [&] { return stopping || generation != seen; });
+                    if (stopping) return;
+                    seen = generation;
+                    fn = task;
+                    ctx = context;
+                    n = chunks;
+                }
+                if (t + 1 >= n) continue;
+                fn(ctx, t + 1);
+                std::scoped_lock lock(mutex);
+                if (--pending == 0) done.notify_one();
+            }
+        }
+    };
+};
+
+}  // namespace nbody
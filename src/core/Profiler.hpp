@@ -0,0 +1,366 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "AllocationCounter.hpp"
+#include "Constants.hpp"
+
+namespace nbody {
+
+// Per-stage frame profiler.
+// - Scope is an RAII timer. A nested scope pauses the one around it, so every stage reports exclusive time and the
+//   stages of a frame add up (Velocity Verlet's gravity refresh counts as gravity, not as integration).
+// - Scopes may run on any thread; time goes into per-stage atomic counters, so timing never takes a lock.
+// - end_frame() (main thread, once per rendered frame) drains the counters into a fixed ring of Frame records, so the
+//   simulation stages of a frame are the physics work finished since the previous frame.
+// - While AllocationCounter is enabled, heap allocations are attributed to stages the same way, and each frame also
+//   records the process-wide total (every thread, inside or outside a stage).
+// - Trace capture: arm_trace(n) also records every scope and Zone (begin/end, thread) of the next n frames into a
+//   preallocated event buffer, for export as a Chrome trace (TraceCapture). Recording threads reserve slots with one
+//   atomic increment; once the buffer is full further zones are counted as dropped.
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Stage : std::uint8_t {
+        Collision,
+        GravityBuild,
+        GravityWalk,
+        Integration,
+        Trails,
+        Diagnostics,
+        Render,
+        UI,
+        Count
+    };
+    static constexpr std::size_t kStages = static_cast<std::size_t>(Stage::Count);
+    static constexpr std::size_t kHistory = constants::profiler_history_frames;
+
+    struct Frame {
+        std::array<float, kStages> stage_ms{};
+        std::array<std::uint32_t, kStages> stage_allocs{};
+        std::array<std::uint64_t, kStages> stage_bytes{};
+        float frame_ms = 0.0f;  // wall time since the previous frame ended
+        std::uint64_t frame_allocs = 0;  // all threads
+        std::uint64_t frame_bytes = 0;
+    };
+
+    struct Stats {
+        float min = 0.0f;
+        float avg = 0.0f;
+        float p99 = 0.0f;
+    };
+
+    struct Summary {
+        std::array<Stats, kStages> stages{};
+        Stats frame{};
+        std::array<float, kStages> allocs{};  // mean allocations per frame
+        std::array<float, kStages> bytes{};  // mean bytes allocated per frame
+        float frame_allocs = 0.0f;
+        float frame_bytes = 0.0f;
+        std::size_t frames = 0;  // frames actually summarised (fewer than asked right after start-up)
+    };
+
+    enum class TraceState : std::uint8_t { Idle, Armed, Recording, Complete };
+
+    // One closed zone; times in ns from the start of the capture.
+    struct TraceEvent {
+        const char* name;
+        const char* category;
+        std::int64_t begin_ns;
+        std::int64_t end_ns;
+        std::uint32_t thread;
+    };
+
+    [[nodiscard]] static auto label(const Stage stage) -> const char* {
+        switch (stage) {
+            case Stage::Collision: return "Collision";
+            case Stage::GravityBuild: return "Gravity build";
+            case Stage::GravityWalk: return "Gravity walk";
+            case Stage::Integration: return "Integration";
+            case Stage::Trails: return "Trails";
+            case Stage::Diagnostics: return "Diagnostics";
+            case Stage::Render: return "Rendering";
+            case Stage::UI: return "UI";
+            case Stage::Count: break;
+        }
+        return "";
+    }
+
+    class Scope {
+    public:
+        explicit Scope(const Stage stage) noexcept : parent_(t_active), start_(Clock::now()) {
+            if (parent_ != Stage::Count) charge(parent_, start_);
+            t_active = stage;
+            mark(start_);
+        }
+        ~Scope() {
+            const Clock::time_point now = Clock::now();
+            const Stage stage = t_active;
+            charge(stage, now);
+            t_active = parent_;
+            mark(now);
+            if (tracing()) record(label(stage), "stage", start_, now);
+        }
+        Scope(const Scope&) = delete;
+        auto operator=(const Scope&) -> Scope& = delete;
+
+    private:
+        Stage parent_;
+        Clock::time_point start_;
+    };
+
+    // Trace-only zone (no per-frame statistics); name must outlive the capture, e.g. a string literal.
+    class Zone {
+    public:
+        explicit Zone(const char* name) noexcept : name_(tracing() ? name : nullptr) {
+            if (name_) start_ = Clock::now();
+        }
+        ~Zone() {
+            if (name_ && tracing()) record(name_, "zone", start_, Clock::now());
+        }
+        Zone(const Zone&) = delete;
+        auto operator=(const Zone&) -> Zone& = delete;
+
+    private:
+        const char* name_;
+        Clock::time_point start_{};
+    };
+
+    // Label the calling thread in traces (threads left unnamed show up as "Thread <n>").
+    static void name_thread(const std::string_view name) noexcept {
+        const std::uint32_t t = thread_index();
+        if (t >= constants::profiler_max_threads) return;
+        auto& slot = s_thread_names[t];
+        const std::size_t n = std::min(name.size(), slot.size() - 1);
+        std::copy_n(name.data(), n, slot.data());
+        slot[n] = '\0';
+    }
+
+    [[nodiscard]] static auto thread_count() noexcept -> std::uint32_t {
+        return std::min<std::uint32_t>(s_thread_count.load(std::memory_order_acquire),
+                                       static_cast<std::uint32_t>(constants::profiler_max_threads));
+    }
+    [[nodiscard]] static auto thread_name(const std::uint32_t t) noexcept -> const char* {
+        return s_thread_names[t].data();
+    }
+
+    // Capture the next `frames` whole frames. Main thread only; ignored unless Idle.
+    static void arm_trace(const std::size_t frames) {
+        if (s_trace_state != TraceState::Idle || frames == 0) return;
+        events().resize(constants::trace_max_events);
+        s_trace_frames_left = frames;
+        s_trace_state = TraceState::Armed;
+    }
+
+    [[nodiscard]] static auto trace_state() noexcept -> TraceState { return s_trace_state; }
+    [[nodiscard]] static auto trace_frames_left() noexcept -> std::size_t { return s_trace_frames_left; }
+
+    // The finished capture, in completion order (valid while Complete).
+    [[nodiscard]] static auto trace_events() noexcept -> std::span<const TraceEvent> {
+        return {events().data(), static_cast<std::size_t>(std::min<std::uint64_t>(s_trace_recorded,
+                                                                                    constants::trace_max_events))};
+    }
+    [[nodiscard]] static auto trace_dropped() noexcept -> std::uint64_t {
+        return s_trace_recorded > constants::trace_max_events ? s_trace_recorded - constants::trace_max_events : 0;
+    }
+
+    // Done with the capture (exported or abandoned); the buffer is kept for the next one.
+    static void release_trace() noexcept {
+        if (s_trace_state == TraceState::Complete) s_trace_state = TraceState::Idle;
+    }
+
+    // Close the current frame: move the accumulated stage times into the ring. Main thread only.
+    static void end_frame() noexcept {
+        const Clock::time_point now = Clock::now();
+        const std::uint64_t n = s_written.load(std::memory_order_relaxed);
+        Frame& f = frames()[n % kHistory];
+        for (std::size_t i = 0; i < kStages; ++i) {
+            f.stage_ms[i] = to_ms(s_pending_ns[i].exchange(0, std::memory_order_relaxed));
+            f.stage_allocs[i] = static_cast<std::uint32_t>(s_pending_allocs[i].exchange(0, std::memory_order_relaxed));
+            f.stage_bytes[i] = s_pending_bytes[i].exchange(0, std::memory_order_relaxed);
+        }
+        const std::uint64_t allocs = AllocationCounter::total();
+        const std::uint64_t bytes = AllocationCounter::total_bytes();
+        f.frame_allocs = allocs - s_frame_allocs_mark;
+        f.frame_bytes = bytes - s_frame_bytes_mark;
+        s_frame_allocs_mark = allocs;
+        s_frame_bytes_mark = bytes;
+        f.frame_ms = n > 0 ? to_ms(elapsed_ns(s_frame_start, now)) : 0.0f;
+        advance_trace(now);
+        s_frame_start = now;
+        s_written.store(n + 1, std::memory_order_release);
+    }
+
+    [[nodiscard]] static auto frame_count() noexcept -> std::size_t {
+        return static_cast<std::size_t>(
+            std::min<std::uint64_t>(s_written.load(std::memory_order_acquire), kHistory));
+    }
+
+    // age 0 is the newest completed frame; age < frame_count().
+    [[nodiscard]] static auto frame(const std::size_t age) noexcept -> const Frame& {
+        return frames()[(s_written.load(std::memory_order_acquire) - 1 - age) % kHistory];
+    }
+
+    // min/avg/p99 of each stage and of the frame time, and mean allocations, over the newest `window` frames.
+    // Main thread only (uses a static scratch buffer, so the panel stays allocation-free).
+    [[nodiscard]] static auto summarize(const std::size_t window) -> Summary {
+        Summary out;
+        out.frames = std::min(window, frame_count());
+        if (out.frames == 0) return out;
+        for (std::size_t s = 0; s <= kStages; ++s) {
+            for (std::size_t age = 0; age < out.frames; ++age) {
+                const Frame& f = frame(age);
+                s_scratch[age] = s < kStages ? f.stage_ms[s] : f.frame_ms;
+            }
+            (s < kStages ? out.stages[s] : out.frame) = stats(out.frames);
+        }
+        const float inv = 1.0f / static_cast<float>(out.frames);
+        for (std::size_t age = 0; age < out.frames; ++age) {
+            const Frame& f = frame(age);
+            for (std::size_t s = 0; s < kStages; ++s) {
+                out.allocs[s] += static_cast<float>(f.stage_allocs[s]) * inv;
+                out.bytes[s] += static_cast<float>(f.stage_bytes[s]) * inv;
+            }
+            out.frame_allocs += static_cast<float>(f.frame_allocs) * inv;
+            out.frame_bytes += static_cast<float>(f.frame_bytes) * inv;
+        }
+        return out;
+    }
+
+private:
+    static inline thread_local Stage t_active = Stage::Count;  // innermost open scope on this thread
+    static inline thread_local Clock::time_point t_mark{};  // when t_active last started or resumed
+    static inline thread_local std::uint64_t t_allocs_mark = 0;  // AllocationCounter::thread_count() at t_mark
+    static inline thread_local std::uint64_t t_bytes_mark = 0;
+    static inline std::array<std::atomic<std::uint64_t>, kStages> s_pending_ns{};
+    static inline std::array<std::atomic<std::uint64_t>, kStages> s_pending_allocs{};
+    static inline std::array<std::atomic<std::uint64_t>, kStages> s_pending_bytes{};
+    static inline std::uint64_t s_frame_allocs_mark = 0;
+    static inline std::uint64_t s_frame_bytes_mark = 0;
+    static inline std::atomic<std::uint64_t> s_written{0};
+    static inline Clock::time_point s_frame_start{};
+    static inline std::array<float, kHistory> s_scratch{};
+
+    static constexpr std::uint32_t kUnnamed = ~std::uint32_t{0};
+    static inline thread_local std::uint32_t t_thread = kUnnamed;  // index into s_thread_names
+    static inline std::atomic<std::uint32_t> s_thread_count{0};
+    static inline std::array<std::array<char, 32>, constants::profiler_max_threads> s_thread_names{};
+
+    // s_tracing gates recording on every thread; the rest of the capture state belongs to the main thread.
+    static inline std::atomic<bool> s_tracing{false};
+    static inline std::atomic<std::uint64_t> s_trace_reserved{0};
+    static inline std::atomic<std::uint64_t> s_trace_committed{0};
+    static inline Clock::time_point s_trace_origin{};  // published to recorders by the release store of s_tracing
+    static inline TraceState s_trace_state = TraceState::Idle;
+    static inline std::size_t s_trace_frames_left = 0;
+    static inline std::uint64_t s_trace_recorded = 0;  // zones reserved when the capture stopped
+
+    [[nodiscard]] static auto tracing() noexcept -> bool { return s_tracing.load(std::memory_order_acquire); }
+
+    static auto events() noexcept -> std::vector<TraceEvent>& {
+        static std::vector<TraceEvent> buffer;
+        return buffer;
+    }
+
+    static auto thread_index() noexcept -> std::uint32_t {
+        if (t_thread == kUnnamed) {
+            t_thread = s_thread_count.fetch_add(1, std::memory_order_relaxed);
+            if (t_thread < constants::profiler_max_threads) {
+                auto& slot = s_thread_names[t_thread];
+                std::snprintf(slot.data(), slot.size(), "Thread %u", t_thread);
+            }
+        }
+        return t_thread;
+    }
+
+    static void record(const char* name, const char* category, const Clock::time_point begin,
+                       const Clock::time_point end) noexcept {
+        const std::uint64_t slot = s_trace_reserved.fetch_add(1, std::memory_order_relaxed);
+        if (slot < constants::trace_max_events) {
+            // Zones opened before the capture started are clipped to its start.
+            const auto since = [](const Clock::time_point t) {
+                return std::max<std::int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                     t - s_trace_origin).count());
+            };
+            events()[slot] = TraceEvent{name, category, since(begin), since(end), thread_index()};
+        }
+        s_trace_committed.fetch_add(1, std::memory_order_release);
+    }
+
+    // Frame-boundary step of the capture state machine (main thread, from end_frame).
+    static void advance_trace(const Clock::time_point now) noexcept {
+        if (s_trace_state == TraceState::Armed) {
+            s_trace_origin = now;
+            s_trace_reserved.store(0, std::memory_order_relaxed);
+            s_trace_committed.store(0, std::memory_order_relaxed);
+            s_trace_state = TraceState::Recording;
+            s_tracing.store(true, std::memory_order_release);
+        } else if (s_trace_state == TraceState::Recording) {
+            record("Frame", "frame", s_frame_start, now);
+            if (--s_trace_frames_left > 0) return;
+            s_tracing.store(false, std::memory_order_release);
+            // Let zones that saw s_tracing set finish writing their slots.
+            std::uint64_t reserved = 0;
+            while (s_trace_committed.load(std::memory_order_acquire) < (reserved = s_trace_reserved.load())) {
+                std::this_thread::yield();
+            }
+            s_trace_recorded = reserved;
+            s_trace_state = TraceState::Complete;
+        }
+    }
+
+    // Function-local so Frame is complete (its member initializers are needed) where the ring is defined.
+    static auto frames() noexcept -> std::array<Frame, kHistory>& {
+        static std::array<Frame, kHistory> ring{};
+        return ring;
+    }
+
+    // Book the time and allocations since the last mark() on this thread to stage.
+    static void charge(const Stage stage, const Clock::time_point now) noexcept {
+        const auto s = static_cast<std::size_t>(stage);
+        s_pending_ns[s].fetch_add(elapsed_ns(t_mark, now), std::memory_order_relaxed);
+        if (const std::uint64_t allocs = AllocationCounter::thread_count() - t_allocs_mark; allocs > 0) {
+            s_pending_allocs[s].fetch_add(allocs, std::memory_order_relaxed);
+            s_pending_bytes[s].fetch_add(AllocationCounter::thread_bytes() - t_bytes_mark, std::memory_order_relaxed);
+        }
+    }
+
+    static void mark(const Clock::time_point now) noexcept {
+        t_mark = now;
+        t_allocs_mark = AllocationCounter::thread_count();
+        t_bytes_mark = AllocationCounter::thread_bytes();
+    }
+
+    static auto elapsed_ns(const Clock::time_point from, const Clock::time_point to) noexcept -> std::uint64_t {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+    }
+
+    static auto to_ms(const std::uint64_t ns) noexcept -> float { return static_cast<float>(ns) * 1e-6f; }
+
+    static auto stats(const std::size_t n) -> Stats {
+        float* v = s_scratch.data();
+        Stats st;
+        st.min = *std::min_element(v, v + n);
+        float sum = 0.0f;
+        for (std::size_t i = 0; i < n; ++i) sum += v[i];
+        st.avg = sum / static_cast<float>(n);
+        // Nearest-rank percentile
+        const std::size_t rank = (n * 99 + 99) / 100 - 1;
+        std::nth_element(v, v + rank, v + n);
+        st.p99 = v[rank];
+        return st;
+    }
+};
+
+}  // namespace nbody
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <flecs.h>
+#include <numbers>
+#include <raylib-cpp.hpp>
+#include <vector>
+
+#include "../physics/SpatialPartition.hpp"
+#include "Config.hpp"
+#include "Constants.hpp"
+#include "Math.hpp"
+#include "TrailPool.hpp"
+
+namespace nbody {
+
+// Immutable view of the simulation published by the simulation thread for the renderer.
+// Body data is stored as parallel arrays (SoA) so the renderer never touches the ECS world.
+struct RenderSnapshot {
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<flecs::entity_t> ids;
+    std::vector<DVec2> positions;
+    std::vector<DVec2> prev_positions;  // positions before the last step, for interpolation
+    std::vector<DVec2> accelerations;
+    std::vector<float> masses;
+    std::vector<float> radii;  // physical radius (m), before radius_scale / min pixel size
+    std::vector<raylib::Color> tints;
+    std::vector<std::uint32_t> draw_order;  // indices sorted by descending mass (small bodies drawn on top)
+    float max_radius = 0.0F;  // largest entry in radii
+
+    // Barnes-Hut tree from the last gravity pass (empty unless BH ran and Config::tree_aggregate is set).
+    // Leaf Cell::body is remapped to an index into the arrays above (-1 if the body is not in this snapshot).
+    std::vector<SpatialPartition::Cell> tree_cells;
+    std::vector<raylib::Color> tree_tints;  // mass-weighted tint per cell
+    std::vector<DVec2> tree_com;  // per-cell centre of mass of the bodies below it, at positions / prev_positions
+    std::vector<DVec2> tree_prev_com;
+
+    std::vector<std::uint32_t> trail_slots;  // body i's slot in trails (TrailPool::kNoSlot = none)
+
+    // Mirror of the simulation's trail pool; kept across publishes so each sync copies only new points.
+    TrailPool trails;
+
+    Config cfg{};
+    double sim_time = 0.0;  // simulated seconds
+    std::uint64_t step = 0;  // number of completed simulation steps
+
+    // Fixed-step interpolation: the renderer sits interp_leftover_s + (now - published_at) wall seconds past the
+    // last step. interp_step_s is the wall duration of one step; 0 disables interpolation (paused, variable dt).
+    double interp_leftover_s = 0.0;
+    double interp_step_s = 0.0;
+    Clock::time_point published_at{};
+
+    [[nodiscard]] auto size() const -> std::size_t { return ids.size(); }
+
+    // Blend factor between prev_positions (0) and positions (1) for a frame drawn at 'now'.
+    [[nodiscard]] auto interpolation_alpha(const Clock::time_point now) const -> double {
+        if (interp_step_s <= 0.0) return 1.0;
+        const double since = std::chrono::duration<double>(now - published_at).count();
+        return std::clamp((interp_leftover_s + since) / interp_step_s, 0.0, 1.0);
+    }
+
+    // Physical radius (m) of a body of the given mass at constants::body_density.
+    [[nodiscard]] static auto radius_for_mass(const float mass) -> float {
+        const double safeMass = std::max(1.0, static_cast<double>(mass));
+        return static_cast<float>(std::cbrt((3.0 * safeMass) / (4.0 * std::numbers::pi * constants::body_density)));
+    }
+
+    [[nodiscard]] auto position_at(const std::size_t i, const double alpha) const -> DVec2 {
+        return prev_positions[i] + (positions[i] - prev_positions[i]) * alpha;
+    }
+
+    // Tree cell k's centre of mass blended like position_at, so aggregates move with the bodies they stand for.
+    [[nodiscard]] auto cell_com_at(const std::size_t k, const double alpha) const -> DVec2 {
+        return tree_prev_com[k] + (tree_com[k] - tree_prev_com[k]) * alpha;
+    }
+
+    // Clears per-body arrays; the trail mirror is kept so the next sync stays incremental.
+    void clear() {
+        ids.clear();
+        positions.clear();
+        prev_positions.clear();
+        accelerations.clear();
+        masses.clear();
+        radii.clear();
+        tints.clear();
+        draw_order.clear();
+        max_radius = 0.0F;
+        tree_cells.clear();
+        tree_tints.clear();
+        tree_com.clear();
+        tree_prev_com.clear();
+        trail_slots.clear();
+    }
+};
+
+}  // namespace nbody
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <flecs.h>
@@ -23,7 +26,9 @@ struct Scenario {
     std::string name;
     std::string description;
     std::vector<std::string> tags;  // simple labels; UI uses comma-separated input
-    std::vector<BodySnapshot> bodies;
+    std::vector<BodySnapshot> bodies;  // empty for file-backed scenarios until loaded
+    std::string file;  // backing scenario file (see ScenarioFile), empty if only in memory
+    std::size_t body_count = 0;  // bodies in the file when bodies is not loaded
     // Minimal config subset to replay scenario faithfully
     double g = nbody::constants::default_g;
     double meter_to_pixel = nbody::constants::default_meter_to_pixel;
@@ -31,7 +36,7 @@ struct Scenario {
     float max_speed = nbody::constants::default_max_speed;
     int bh_threshold = nbody::constants::default_bh_threshold;
     float bh_theta = nbody::constants::default_bh_theta;
-    bool use_fixed_dt = false;
+    bool use_fixed_dt = true;
     float fixed_dt = nbody::constants::default_fixed_dt;
     float time_scale = nbody::constants::default_time_scale;
     int integrator = 1;
@@ -44,6 +49,42 @@ struct Scenario {
     float radius_scale = nbody::constants::default_radius_scale;
 };
 
+// Body data column by column, laid out exactly like the ECS component columns so it can be bulk-copied.
+struct BodyColumns {
+    const DVec2* positions = nullptr;
+    const DVec2* velocities = nullptr;
+    const float* masses = nullptr;
+    const std::uint8_t* pinned = nullptr;  // 0 or 1
+    const raylib::Color* tints = nullptr;
+    std::size_t count = 0;
+    const double* radii = nullptr;  // physical radius (m); nullptr = no Radius component (derived from mass)
+};
+
+// Owning column storage for bodies built off-world (importers, generators).
+struct BodyBuffers {
+    std::vector<DVec2> positions;
+    std::vector<DVec2> velocities;
+    std::vector<float> masses;
+    std::vector<std::uint8_t> pinned;
+    std::vector<raylib::Color> tints;
+    std::vector<double> radii;  // empty = radii derived from mass
+
+    [[nodiscard]] auto size() const -> std::size_t { return positions.size(); }
+    [[nodiscard]] auto columns() const -> BodyColumns {
+        return BodyColumns{positions.data(), velocities.data(), masses.data(),
+                           pinned.data(),    tints.data(),      size(),
+                           radii.empty() ? nullptr : radii.data()};
+    }
+    // Size every column except radii for n bodies, all unpinned.
+    void resize(const std::size_t n) {
+        positions.resize(n);
+        velocities.resize(n);
+        masses.resize(n);
+        pinned.assign(n, 0);
+        tints.resize(n);
+    }
+};
+
 struct ScenarioStore {
     std::vector<Scenario> items;
     int selected = -1;
@@ -78,33 +119,132 @@ inline Scenario snapshot_from_world(const flecs::world& w, const std::string& na
     return s;
 }
 
-inline void apply_scenario_bodies_only(const flecs::world& w, const Scenario& s) {
-    // Clear all current bodies
+inline void clear_bodies(const flecs::world& w) {
     std::vector<flecs::entity> toDel;
     w.each([&](const flecs::entity e, const Position&) { toDel.push_back(e); });
     for (auto& e : toDel) e.destruct();
+}
+
+// Create bodies straight from component-shaped columns with flecs bulk creation: one table append per chunk
+// instead of a chain of set() calls per body.
+inline void spawn_bodies(const flecs::world& w, const BodyColumns& cols) {
+    static_assert(sizeof(Position) == sizeof(DVec2) && sizeof(Velocity) == sizeof(DVec2));
+    static_assert(sizeof(Mass) == sizeof(float) && sizeof(Tint) == sizeof(raylib::Color));
+    static_assert(sizeof(Radius) == sizeof(double));
+    const std::size_t chunk = std::min(cols.count, nbody::constants::bulk_spawn_chunk);
+    std::vector<Pinned> pins(chunk);
+    const std::vector<DVec2> zeros(chunk, DVec2{0.0, 0.0});
+    for (std::size_t begin = 0; begin < cols.count; begin += chunk) {
+        const std::size_t n = std::min(chunk, cols.count - begin);
+        for (std::size_t i = 0; i < n; ++i) pins[i].value = cols.pinned[begin + i] != 0;
 
-    // Rebuild bodies
-    for (const auto& b : s.bodies) {
-        w.entity()
-            .set<Position>({b.pos})
-            .set<Velocity>({b.vel})
-            .set<Acceleration>({DVec2{0.0, 0.0}})
-            .set<PrevAcceleration>({DVec2{0.0, 0.0}})
-            .set<Mass>({std::max(0.0f, b.mass)})
-            .set<Pinned>({b.pinned})
-            .set<Tint>({b.tint})
-            .set<Trail>({{}})
-            .add<Selectable>()
-            .set<Draggable>({true, nbody::constants::drag_vel_scale});
+        // Components with a null data pointer are default-constructed (Trail, Selectable, Draggable).
+        const ecs_id_t ids[] = {w.component<Position>().id(),     w.component<PrevPosition>().id(),
+                                w.component<Velocity>().id(),     w.component<Acceleration>().id(),
+                                w.component<PrevAcceleration>().id(), w.component<Mass>().id(),
+                                w.component<Pinned>().id(),       w.component<Tint>().id(),
+                                w.component<Trail>().id(),        w.component<Selectable>().id(),
+                                w.component<Draggable>().id(),    w.component<Radius>().id()};
+        void* data[] = {const_cast<DVec2*>(cols.positions + begin),
+                        const_cast<DVec2*>(cols.positions + begin),
+                        const_cast<DVec2*>(cols.velocities + begin),
+                        const_cast<DVec2*>(zeros.data()),
+                        const_cast<DVec2*>(zeros.data()),
+                        const_cast<float*>(cols.masses + begin),
+                        pins.data(),
+                        const_cast<raylib::Color*>(cols.tints + begin),
+                        nullptr,
+                        nullptr,
+                        nullptr,
+                        cols.radii ? const_cast<double*>(cols.radii + begin) : nullptr};
+        const std::size_t idCount = std::size(ids) - (cols.radii ? 0 : 1);  // Radius last, only when given
+        ecs_bulk_desc_t desc{};
+        desc.count = static_cast<int32_t>(n);
+        std::copy(std::begin(ids), std::begin(ids) + static_cast<std::ptrdiff_t>(idCount), desc.ids);
+        desc.data = data;
+        ecs_bulk_init(w.c_ptr(), &desc);
     }
 }
 
-inline void apply_scenario_to_world(const flecs::world& w, const Scenario& s) {
-    // Apply bodies only first
-    apply_scenario_bodies_only(w, s);
+// Make the world's bodies match cols while keeping live entities: existing bodies are overwritten in place (no
+// archetype change unless their optional Radius/Density differ), surplus ones are deleted in the same deferred
+// batch, and only the missing tail is bulk-created. Loading a scenario of similar size therefore leaves the
+// flecs tables, and every cache keyed on them, intact. A reused entity is a different body afterwards, so it loses
+// the Selected tag; Interaction drops a selection whose entity no longer carries it.
+inline void assign_bodies(const flecs::world& w, const BodyColumns& cols) {
+    auto* trails = w.get_mut<TrailPool>();
+    std::size_t next = 0;
+    std::size_t matched = 0;
+    w.defer_begin();
+    w.each([&](const flecs::entity e, Position& p, PrevPosition& pp, Velocity& v, Acceleration& a,
+               PrevAcceleration& pa, Mass& m, Pinned& pin, Tint& t, const Trail& trail) {
+        ++matched;
+        if (next == cols.count) {
+            e.destruct();
+            return;
+        }
+        const std::size_t i = next++;
+        p.value = cols.positions[i];
+        pp.value = cols.positions[i];
+        v.value = cols.velocities[i];
+        a.value = DVec2{0.0, 0.0};
+        pa.value = DVec2{0.0, 0.0};
+        m.value = cols.masses[i];
+        pin.value = cols.pinned[i] != 0;
+        t.value = cols.tints[i];
+        if (trails && trails->owned_by(trail.slot, e.id())) trails->clear(trail.slot);
+        if (cols.radii) {
+            e.set<Radius>({cols.radii[i]});
+        } else if (e.has<Radius>()) {
+            e.remove<Radius>();
+        }
+        if (e.has<Density>()) e.remove<Density>();
+        if (e.has<Selected>()) e.remove<Selected>();
+    });
+    // Bodies missing part of the standard component set are not reused.
+    if (matched != static_cast<std::size_t>(w.count<Position>())) {
+        w.each([&](const flecs::entity e, const Position&) {
+            if (!e.has<PrevPosition>() || !e.has<Velocity>() || !e.has<Acceleration>() ||
+                !e.has<PrevAcceleration>() || !e.has<Mass>() || !e.has<Pinned>() || !e.has<Tint>() ||
+                !e.has<Trail>())
+                e.destruct();
+        });
+    }
+    w.defer_end();
 
-    // Apply config subset
+    if (next < cols.count) {
+        BodyColumns rest = cols;
+        rest.positions += next;
+        rest.velocities += next;
+        rest.masses += next;
+        rest.pinned += next;
+        rest.tints += next;
+        if (rest.radii) rest.radii += next;
+        rest.count -= next;
+        spawn_bodies(w, rest);
+    }
+}
+
+inline void apply_scenario_bodies_only(const flecs::world& w, const Scenario& s) {
+    // Overwrite bodies in place, creating or deleting only the difference
+    const std::size_t n = s.bodies.size();
+    std::vector<DVec2> positions(n);
+    std::vector<DVec2> velocities(n);
+    std::vector<float> masses(n);
+    std::vector<std::uint8_t> pinned(n);
+    std::vector<raylib::Color> tints(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        const BodySnapshot& b = s.bodies[i];
+        positions[i] = b.pos;
+        velocities[i] = b.vel;
+        masses[i] = std::max(0.0f, b.mass);
+        pinned[i] = b.pinned ? 1 : 0;
+        tints[i] = b.tint;
+    }
+    assign_bodies(w, BodyColumns{positions.data(), velocities.data(), masses.data(), pinned.data(), tints.data(), n});
+}
+
+inline void apply_scenario_config(const flecs::world& w, const Scenario& s) {
     if (auto* cfg = w.get_mut<Config>()) {
         cfg->g = s.g;
         cfg->meter_to_pixel = s.meter_to_pixel;
@@ -127,4 +267,12 @@ inline void apply_scenario_to_world(const flecs::world& w, const Scenario& s) {
     }
 }
 
+inline void apply_scenario_to_world(const flecs::world& w, const Scenario& s) {
+    // Apply bodies only first
+    apply_scenario_bodies_only(w, s);
+
+    // Apply config subset
+    apply_scenario_config(w, s);
+}
+
 }  // namespace nbody
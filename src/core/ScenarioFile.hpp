@@ -0,0 +1,362 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "Scenario.hpp"
+
+namespace nbody {
+
+// Versioned binary scenario files (*.nbscn), persisted in scenario_dir().
+//
+// Layout (native little-endian, all offsets from the start of the file):
+//   Header      fixed-size, magic + version + block table
+//   Config      ConfigBlock (readers accept larger blocks from newer writers)
+//   Meta        name, description and tags as u32-length-prefixed UTF-8 strings
+//   Columns     one array per body field, each 64-byte aligned and shaped like the ECS component column:
+//               Position (DVec2), Velocity (DVec2), Mass (f32), Pinned (u8), Tint (RGBA8)
+//
+// Opening maps the file; body columns are used in place and bulk-copied into the world, so load time is
+// dominated by the ECS append rather than parsing.
+class ScenarioFile {
+public:
+    static constexpr std::array<char, 8> kMagic{'N', 'B', 'O', 'D', 'Y', 'S', 'C', 'N'};
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr std::uint32_t kEndianMark = 0x01020304;
+    static constexpr std::size_t kAlignment = 64;
+    static constexpr const char* kExtension = ".nbscn";
+
+    enum Column : std::uint32_t { kPosition, kVelocity, kMass, kPinned, kTint, kColumnCount };
+
+    struct Block {
+        std::uint64_t offset = 0;
+        std::uint64_t size = 0;
+    };
+
+    struct Header {
+        std::array<char, 8> magic = kMagic;
+        std::uint32_t version = kVersion;
+        std::uint32_t header_size = sizeof(Header);
+        std::uint32_t endian = kEndianMark;
+        std::uint32_t column_count = kColumnCount;
+        std::uint64_t body_count = 0;
+        Block config;
+        Block meta;
+        std::array<Block, kColumnCount> columns{};
+    };
+
+    struct ConfigBlock {
+        double g;
+        double meter_to_pixel;
+        float softening;
+        float max_speed;
+        float bh_theta;
+        float fixed_dt;
+        float time_scale;
+        float max_substep;
+        float radius_scale;
+        std::int32_t bh_threshold;
+        std::int32_t integrator;
+        std::int32_t max_substeps_per_frame;
+        std::int32_t trail_max;
+        std::uint8_t use_fixed_dt;
+        std::uint8_t draw_trails;
+        std::uint8_t draw_velocity;
+        std::uint8_t draw_acceleration;
+    };
+
+    // An opened scenario file: metadata and config parsed, body columns pointing into the mapping.
+    struct Mapped {
+        MappedFile file;
+        Scenario info;  // metadata + config, no bodies
+        BodyColumns columns;
+    };
+
+    // Where the scenario library lives: $XDG_DATA_HOME (or ~/.local/share)/raylib-nbody/scenarios.
+    static std::filesystem::path scenario_dir() {
+        std::filesystem::path base;
+#if defined(_WIN32)
+        if (const char* appData = std::getenv("APPDATA")) base = appData;
+#else
+        if (const char* xdg = std::getenv("XDG_DATA_HOME"); xdg && xdg[0] != '\0') {
+            base = xdg;
+        } else if (const char* home = std::getenv("HOME")) {
+            base = std::filesystem::path(home) / ".local" / "share";
+        }
+#endif
+        if (base.empty()) base = std::filesystem::temp_directory_path();
+        return base / "raylib-nbody" / "scenarios";
+    }
+
+    // A new file path in dir named <prefix>-<local date>-<time><extension>, with "-2", "-3"... appended when a file
+    // from the same second already exists. Used for recordings and traces.
+    static std::filesystem::path timestamped_path(const std::filesystem::path& dir, const char* prefix,
+                                                  const char* extension) {
+        const std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        std::tm local{};
+#if defined(_WIN32)
+        localtime_s(&local, &now);
+#else
+        localtime_r(&now, &local);
+#endif
+        std::array<char, 32> stamp{};
+        std::strftime(stamp.data(), stamp.size(), "%Y%m%d-%H%M%S", &local);
+        const std::string stem = std::string(prefix) + "-" + stamp.data();
+        auto path = dir / (stem + extension);
+        for (int i = 2; std::filesystem::exists(path); ++i) path = dir / (stem + "-" + std::to_string(i) + extension);
+        return path;
+    }
+
+    // A new file path in scenario_dir() derived from the scenario name.
+    static std::filesystem::path unique_path(const std::string& name) {
+        std::string stem;
+        for (const char c : name) {
+            stem += (std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_') ? c : '_';
+        }
+        if (stem.empty()) stem = "scenario";
+        const auto dir = scenario_dir();
+        auto path = dir / (stem + kExtension);
+        for (int i = 2; std::filesystem::exists(path); ++i) path = dir / (stem + "-" + std::to_string(i) + kExtension);
+        return path;
+    }
+
+    static bool save(const std::filesystem::path& path, const Scenario& s) {
+        const std::size_t n = s.bodies.size();
+        Header h{};
+        h.body_count = n;
+        const ConfigBlock cfg = to_block(s);
+        const std::vector<char> meta = encode_meta(s);
+
+        std::uint64_t at = sizeof(Header);
+        h.config = Block{at, sizeof(ConfigBlock)};
+        at += sizeof(ConfigBlock);
+        h.meta = Block{at, meta.size()};
+        at += meta.size();
+        constexpr std::array<std::size_t, kColumnCount> kStride{sizeof(DVec2), sizeof(DVec2), sizeof(float),
+                                                                sizeof(std::uint8_t), sizeof(raylib::Color)};
+        for (std::uint32_t c = 0; c < kColumnCount; ++c) {
+            at = align(at);
+            h.columns[c] = Block{at, kStride[c] * n};
+            at += h.columns[c].size;
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+        const auto tmp = std::filesystem::path(path).concat(".tmp");
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out) return false;
+            write_raw(out, &h, sizeof(h));
+            write_raw(out, &cfg, sizeof(cfg));
+            write_raw(out, meta.data(), meta.size());
+            const auto column = [&](const std::uint32_t c, const auto& field) {
+                pad_to(out, h.columns[c].offset);
+                using T = std::remove_cvref_t<decltype(field(s.bodies.front()))>;
+                std::vector<T> buf;
+                buf.reserve(std::min(n, kWriteChunk));
+                for (std::size_t i = 0; i < n; i += kWriteChunk) {
+                    buf.clear();
+                    for (std::size_t j = i; j < std::min(n, i + kWriteChunk); ++j) buf.push_back(field(s.bodies[j]));
+                    write_raw(out, buf.data(), buf.size() * sizeof(T));
+                }
+            };
+            if (n > 0) {
+                column(kPosition, [](const BodySnapshot& b) { return b.pos; });
+                column(kVelocity, [](const BodySnapshot& b) { return b.vel; });
+                column(kMass, [](const BodySnapshot& b) { return b.mass; });
+                column(kPinned, [](const BodySnapshot& b) { return static_cast<std::uint8_t>(b.pinned ? 1 : 0); });
+                column(kTint, [](const BodySnapshot& b) { return b.tint; });
+            }
+            if (!out) return false;
+        }
+        std::filesystem::rename(tmp, path, ec);
+        return !ec;
+    }
+
+    // Map and validate a file. Body masses must be finite and non-negative.
+    static std::optional<Mapped> open(const std::filesystem::path& path) {
+        Mapped m{};
+        if (!m.file.open(path)) return std::nullopt;
+        const std::byte* base = m.file.data();
+        const std::size_t size = m.file.size();
+        if (size < sizeof(Header)) return std::nullopt;
+        Header h{};
+        std::memcpy(&h, base, sizeof(h));
+        if (h.magic != kMagic || h.version != kVersion || h.endian != kEndianMark || h.header_size < sizeof(Header) ||
+            h.column_count < kColumnCount) {
+            return std::nullopt;
+        }
+        const auto inside = [&](const Block& b) { return b.offset <= size && b.size <= size - b.offset; };
+        if (!inside(h.config) || h.config.size < sizeof(ConfigBlock) || !inside(h.meta)) return std::nullopt;
+
+        const std::size_t n = h.body_count;
+        constexpr std::array<std::size_t, kColumnCount> kStride{sizeof(DVec2), sizeof(DVec2), sizeof(float),
+                                                                sizeof(std::uint8_t), sizeof(raylib::Color)};
+        for (std::uint32_t c = 0; c < kColumnCount; ++c) {
+            const Block& b = h.columns[c];
+            if (!inside(b) || b.offset % kAlignment != 0 || n > b.size / kStride[c]) return std::nullopt;
+        }
+
+        ConfigBlock cfg{};
+        std::memcpy(&cfg, base + h.config.offset, sizeof(cfg));
+        from_block(cfg, m.info);
+        if (!decode_meta(base + h.meta.offset, h.meta.size, m.info)) return std::nullopt;
+        m.info.file = path.string();
+        m.info.body_count = n;
+
+        m.columns.count = n;
+        m.columns.positions = reinterpret_cast<const DVec2*>(base + h.columns[kPosition].offset);
+        m.columns.velocities = reinterpret_cast<const DVec2*>(base + h.columns[kVelocity].offset);
+        m.columns.masses = reinterpret_cast<const float*>(base + h.columns[kMass].offset);
+        m.columns.pinned = reinterpret_cast<const std::uint8_t*>(base + h.columns[kPinned].offset);
+        m.columns.tints = reinterpret_cast<const raylib::Color*>(base + h.columns[kTint].offset);
+        return m;
+    }
+
+    // Metadata and config only; body columns are not touched, so listing a library of large files is cheap.
+    static std::optional<Scenario> read_info(const std::filesystem::path& path) {
+        auto m = open(path);
+        if (!m) return std::nullopt;
+        return std::move(m->info);
+    }
+
+    // Replace the world's bodies with the file's (and optionally its config).
+    static bool load_into(const flecs::world& w, const std::filesystem::path& path, const bool applyConfig) {
+        auto m = open(path);
+        if (!m) return false;
+        const BodyColumns& cols = m->columns;
+        m->file.will_need(0, m->file.size());
+        for (std::size_t i = 0; i < cols.count; ++i) {
+            if (!std::isfinite(cols.masses[i]) || cols.masses[i] < 0.0F) return false;
+        }
+        assign_bodies(w, cols);
+        if (applyConfig) apply_scenario_config(w, m->info);
+        return true;
+    }
+
+    // Fill the store with every readable scenario file in scenario_dir(), sorted by name.
+    static void load_library(ScenarioStore& store) {
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(scenario_dir(), ec)) {
+            if (!entry.is_regular_file() || entry.path().extension() != kExtension) continue;
+            if (auto info = read_info(entry.path())) store.items.push_back(std::move(*info));
+        }
+        std::sort(store.items.begin(), store.items.end(),
+                  [](const Scenario& a, const Scenario& b) { return a.name < b.name; });
+    }
+
+private:
+    static constexpr std::size_t kWriteChunk = 1 << 16;
+
+    static std::uint64_t align(const std::uint64_t at) { return (at + kAlignment - 1) / kAlignment * kAlignment; }
+
+    static void write_raw(std::ofstream& out, const void* p, const std::size_t bytes) {
+        out.write(static_cast<const char*>(p), static_cast<std::streamsize>(bytes));
+    }
+
+    static void pad_to(std::ofstream& out, const std::uint64_t offset) {
+        static constexpr std::array<char, kAlignment> kZeros{};
+        const auto at = static_cast<std::uint64_t>(out.tellp());
+        if (offset > at) write_raw(out, kZeros.data(), static_cast<std::size_t>(offset - at));
+    }
+
+    static ConfigBlock to_block(const Scenario& s) {
+        return ConfigBlock{s.g,
+                           s.meter_to_pixel,
+                           s.softening,
+                           s.max_speed,
+                           s.bh_theta,
+                           s.fixed_dt,
+                           s.time_scale,
+                           s.max_substep,
+                           s.radius_scale,
+                           s.bh_threshold,
+                           s.integrator,
+                           s.max_substeps_per_frame,
+                           s.trail_max,
+                           static_cast<std::uint8_t>(s.use_fixed_dt),
+                           static_cast<std::uint8_t>(s.draw_trails),
+                           static_cast<std::uint8_t>(s.draw_velocity),
+                           static_cast<std::uint8_t>(s.draw_acceleration)};
+    }
+
+    static void from_block(const ConfigBlock& c, Scenario& s) {
+        s.g = c.g;
+        s.meter_to_pixel = c.meter_to_pixel;
+        s.softening = c.softening;
+        s.max_speed = c.max_speed;
+        s.bh_theta = c.bh_theta;
+        s.fixed_dt = c.fixed_dt;
+        s.time_scale = c.time_scale;
+        s.max_substep = c.max_substep;
+        s.radius_scale = c.radius_scale;
+        s.bh_threshold = c.bh_threshold;
+        s.integrator = c.integrator;
+        s.max_substeps_per_frame = c.max_substeps_per_frame;
+        s.trail_max = c.trail_max;
+        s.use_fixed_dt = c.use_fixed_dt != 0;
+        s.draw_trails = c.draw_trails != 0;
+        s.draw_velocity = c.draw_velocity != 0;
+        s.draw_acceleration = c.draw_acceleration != 0;
+    }
+
+    static std::vector<char> encode_meta(const Scenario& s) {
+        std::vector<char> out;
+        const auto put = [&](const std::string& str) {
+            const auto len = static_cast<std::uint32_t>(str.size());
+            const auto* p = reinterpret_cast<const char*>(&len);
+            out.insert(out.end(), p, p + sizeof(len));
+            out.insert(out.end(), str.begin(), str.end());
+        };
+        put(s.name);
+        put(s.description);
+        const auto count = static_cast<std::uint32_t>(s.tags.size());
+        const auto* p = reinterpret_cast<const char*>(&count);
+        out.insert(out.end(), p, p + sizeof(count));
+        for (const auto& t : s.tags) put(t);
+        return out;
+    }
+
+    static bool decode_meta(const std::byte* p, const std::size_t size, Scenario& s) {
+        std::size_t at = 0;
+        const auto u32 = [&](std::uint32_t& v) {
+            if (size - at < sizeof(v)) return false;
+            std::memcpy(&v, p + at, sizeof(v));
+            at += sizeof(v);
+            return true;
+        };
+        const auto str = [&](std::string& v) {
+            std::uint32_t len = 0;
+            if (!u32(len) || size - at < len) return false;
+            v.assign(reinterpret_cast<const char*>(p + at), len);
+            at += len;
+            return true;
+        };
+        std::uint32_t tagCount = 0;
+        if (!str(s.name) || !str(s.description) || !u32(tagCount)) return false;
+        s.tags.clear();
+        for (std::uint32_t i = 0; i < tagCount; ++i) {
+            std::string t;
+            if (!str(t)) return false;
+            s.tags.push_back(std::move(t));
+        }
+        return true;
+    }
+};
+
+}  // namespace nbody
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace nbody {
+
+// Trail history for every body in one preallocated SoA ring buffer pool.
+// - Each body owns a slot of fixed capacity; append is O(1) and never allocates once the pool is sized.
+// - A slot's points are read oldest-first as two contiguous spans (the ring may wrap once).
+// - A mirror pool (the render snapshot's) catches up with sync_from(), copying only points appended since
+//   its last sync, so publishing trails does not copy every trail every frame.
+class TrailPool {
+public:
+    static constexpr std::uint32_t kNoSlot = std::numeric_limits<std::uint32_t>::max();
+
+    struct Span {
+        const float* x = nullptr;
+        const float* y = nullptr;
+        std::size_t size = 0;
+    };
+
+    [[nodiscard]] auto capacity() const -> std::size_t { return capacity_; }
+    [[nodiscard]] auto slots() const -> std::size_t { return count_.size(); }
+    [[nodiscard]] auto in_use() const -> std::size_t { return count_.size() - free_.size(); }
+    [[nodiscard]] auto size(const std::uint32_t slot) const -> std::size_t {
+        return valid(slot) ? count_[slot] : 0;
+    }
+
+    // Change the per-body capacity. Existing history is dropped; slot assignments are kept.
+    void set_capacity(const std::size_t capacity) {
+        if (capacity == capacity_) return;
+        capacity_ = capacity;
+        xs_.assign(slots() * capacity_, 0.0F);
+        ys_.assign(slots() * capacity_, 0.0F);
+        for (std::size_t s = 0; s < slots(); ++s) clear(static_cast<std::uint32_t>(s));
+    }
+
+    // Grow storage up front so acquiring up to n slots does not reallocate.
+    void reserve(const std::size_t n) {
+        if (n <= slots()) return;
+        xs_.reserve(n * capacity_);
+        ys_.reserve(n * capacity_);
+        head_.reserve(n);
+        count_.reserve(n);
+        appended_.reserve(n);
+        epoch_.reserve(n);
+        owner_.reserve(n);
+        seen_.reserve(n);
+    }
+
+    auto acquire(const std::uint64_t owner) -> std::uint32_t {
+        std::uint32_t slot = 0;
+        if (!free_.empty()) {
+            slot = free_.back();
+            free_.pop_back();
+        } else {
+            slot = static_cast<std::uint32_t>(slots());
+            xs_.resize(xs_.size() + capacity_, 0.0F);
+            ys_.resize(ys_.size() + capacity_, 0.0F);
+            head_.push_back(0);
+            count_.push_back(0);
+            appended_.push_back(0);
+            epoch_.push_back(0);
+            owner_.push_back(0);
+            seen_.push_back(0);
+        }
+        clear(slot);
+        owner_[slot] = owner;
+        seen_[slot] = stamp_;
+        return slot;
+    }
+
+    void release(const std::uint32_t slot) {
+        if (!valid(slot) || owner_[slot] == 0) return;
+        clear(slot);
+        owner_[slot] = 0;
+        free_.push_back(slot);
+    }
+
+    [[nodiscard]] auto owned_by(const std::uint32_t slot, const std::uint64_t owner) const -> bool {
+        return valid(slot) && owner != 0 && owner_[slot] == owner;
+    }
+
+    void clear(const std::uint32_t slot) {
+        head_[slot] = 0;
+        count_[slot] = 0;
+        appended_[slot] = 0;
+        ++epoch_[slot];
+    }
+
+    void push(const std::uint32_t slot, const float x, const float y) {
+        if (capacity_ == 0) return;
+        const std::size_t at = static_cast<std::size_t>(slot) * capacity_ + head_[slot];
+        xs_[at] = x;
+        ys_[at] = y;
+        head_[slot] = static_cast<std::uint32_t>((head_[slot] + 1) % capacity_);
+        count_[slot] = static_cast<std::uint32_t>(std::min<std::size_t>(count_[slot] + 1, capacity_));
+        ++appended_[slot];
+        seen_[slot] = stamp_;
+    }
+
+    // Oldest-first view of a slot: spans[0] then spans[1].
+    [[nodiscard]] auto spans(const std::uint32_t slot) const -> std::array<Span, 2> {
+        if (!valid(slot) || count_[slot] == 0) return {};
+        const std::size_t base = static_cast<std::size_t>(slot) * capacity_;
+        const std::size_t n = count_[slot];
+        const std::size_t tail = (head_[slot] + capacity_ - n) % capacity_;  // oldest point
+        const std::size_t first = std::min(n, capacity_ - tail);
+        return {Span{xs_.data() + base + tail, ys_.data() + base + tail, first},
+                Span{xs_.data() + base, ys_.data() + base, n - first}};
+    }
+
+    // Release slots that were not pushed to since the previous sweep; their bodies are gone.
+    void sweep() {
+        for (std::size_t s = 0; s < slots(); ++s) {
+            if (owner_[s] != 0 && seen_[s] != stamp_) release(static_cast<std::uint32_t>(s));
+        }
+        ++stamp_;
+    }
+
+    // Bring this pool up to date with src, copying only points appended since the last sync.
+    void sync_from(const TrailPool& src) {
+        if (capacity_ != src.capacity_) {
+            capacity_ = src.capacity_;
+            xs_.clear();
+            ys_.clear();
+            head_.clear();
+            count_.clear();
+            appended_.clear();
+            epoch_.clear();
+        }
+        const std::size_t n = src.slots();
+        xs_.resize(n * capacity_, 0.0F);
+        ys_.resize(n * capacity_, 0.0F);
+        head_.resize(n, 0);
+        count_.resize(n, 0);
+        appended_.resize(n, 0);
+        epoch_.resize(n, std::numeric_limits<std::uint32_t>::max());
+        for (std::size_t s = 0; s < n; ++s) {
+            const std::size_t base = s * capacity_;
+            const bool sameHistory = epoch_[s] == src.epoch_[s] && appended_[s] <= src.appended_[s];
+            const std::uint64_t fresh = sameHistory ? src.appended_[s] - appended_[s] : src.count_[s] + 1;
+            if (fresh == 0) continue;
+            if (fresh >= src.count_[s]) {
+                // Everything is new (or the history changed): copy the live prefix of the slot. Until a ring
+                // wraps its points sit in [0, count); once full, the whole slot is live.
+                std::copy_n(src.xs_.begin() + static_cast<std::ptrdiff_t>(base), src.count_[s],
+                            xs_.begin() + static_cast<std::ptrdiff_t>(base));
+                std::copy_n(src.ys_.begin() + static_cast<std::ptrdiff_t>(base), src.count_[s],
+                            ys_.begin() + static_cast<std::ptrdiff_t>(base));
+            } else {
+                for (std::uint64_t k = fresh; k > 0; --k) {
+                    const std::size_t at = base + (src.head_[s] + capacity_ - static_cast<std::size_t>(k)) % capacity_;
+                    xs_[at] = src.xs_[at];
+                    ys_[at] = src.ys_[at];
+                }
+            }
+            head_[s] = src.head_[s];
+            count_[s] = src.count_[s];
+            appended_[s] = src.appended_[s];
+            epoch_[s] = src.epoch_[s];
+        }
+    }
+
+private:
+    std::size_t capacity_ = 0;  // points per slot
+    std::vector<float> xs_;  // slots * capacity, slot-major
+    std::vector<float> ys_;
+    std::vector<std::uint32_t> head_;  // next write index within the slot
+    std::vector<std::uint32_t> count_;  // live points in the slot
+    std::vector<std::uint64_t> appended_;  // total pushes since the slot was last cleared
+    std::vector<std::uint32_t> epoch_;  // bumped whenever a slot's history is discarded
+    std::vector<std::uint64_t> owner_;  // owning entity id (0 = free)
+    std::vector<std::uint32_t> seen_;  // sweep stamp at which the owner was last seen
+    std::vector<std::uint32_t> free_;
+    std::uint32_t stamp_ = 1;
+
+    [[nodiscard]] auto valid(const std::uint32_t slot) const -> bool { return slot < count_.size(); }
+};
+
+}  // namespace nbody
@@ -0,0 +1,767 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "Math.hpp"
+
+namespace nbody {
+
+// Trajectory files (*.nbtraj): body ids, positions, velocities, masses and tints sampled every record_interval
+// steps.
+//
+//   FileHeader
+//   Chunk*      ChunkPrefix + stored bytes; a chunk holds up to frames_per_chunk frames
+//   Index       ChunkIndex[chunk_count], one entry per chunk for random access
+//   Footer      where the index starts; missing if the writer died, in which case chunks can still be walked
+//
+// Raw chunk: FrameHeader[frame_count], then per frame four 64-bit word arrays (ids, positions, velocities,
+// attributes = mass bits | tint << 32), each XOR-delta'd against the same array of the previous frame (unless
+// the frame is a keyframe), then byte-shuffled so byte k of every word is contiguous. Slowly moving bodies leave
+// the high bytes of the delta zero, which the zero-run codec below turns into a few bytes per run.
+// The previous frame may sit in the previous chunk, so even one-frame chunks (huge scenes) stay delta-encoded.
+// Only chunks flagged ChunkIndex::keyframe decode on their own; seeking decodes forward from the nearest one.
+namespace trajectory {
+
+inline constexpr std::array<char, 8> kMagic{'N', 'B', 'O', 'D', 'Y', 'T', 'R', 'J'};
+inline constexpr std::array<char, 8> kFooterMagic{'N', 'B', 'T', 'R', 'J', 'E', 'N', 'D'};
+inline constexpr std::uint32_t kVersion = 2;
+inline constexpr std::uint32_t kChunkMagic = 0x4B4E4843;  // "CHNK"
+inline constexpr std::uint32_t kEndianMark = 0x01020304;
+inline constexpr std::uint32_t kCodecZeroRun = 1;
+inline constexpr const char* kExtension = ".nbtraj";
+
+struct FileHeader {
+    std::array<char, 8> magic = kMagic;
+    std::uint32_t version = kVersion;
+    std::uint32_t header_size = sizeof(FileHeader);
+    std::uint32_t endian = kEndianMark;
+    std::uint32_t codec = kCodecZeroRun;
+    std::uint32_t record_interval = 1;  // simulation steps between frames
+    std::uint32_t frames_per_chunk = 1;
+};
+
+struct ChunkPrefix {
+    std::uint64_t raw_size = 0;
+    std::uint64_t stored_size = 0;
+    std::uint32_t frame_count = 0;
+    std::uint32_t magic = kChunkMagic;
+};
+
+struct FrameHeader {
+    std::uint64_t step = 0;
+    double sim_time = 0.0;
+    std::uint64_t body_count = 0;
+    std::uint32_t keyframe = 0;
+    std::uint32_t reserved = 0;
+};
+
+struct ChunkIndex {
+    std::uint64_t offset = 0;  // of the ChunkPrefix
+    std::uint64_t stored_size = 0;
+    std::uint64_t raw_size = 0;
+    std::uint64_t first_frame = 0;
+    std::uint32_t frame_count = 0;
+    std::uint32_t keyframe = 0;  // 1 if the first frame is a keyframe, so the chunk decodes on its own
+    std::uint64_t first_step = 0;
+    double first_time = 0.0;
+    double last_time = 0.0;
+};
+
+struct Footer {
+    std::uint64_t index_offset = 0;
+    std::uint64_t chunk_count = 0;
+    std::uint64_t frame_count = 0;
+    std::array<char, 8> magic = kFooterMagic;
+};
+
+// Words per body in a frame payload: id, position x/y, velocity x/y, attributes.
+inline constexpr std::size_t kWordsPerBody = 6;
+
+[[nodiscard]] inline auto pack_attributes(const float mass, const raylib::Color tint) -> std::uint64_t {
+    const auto rgba = static_cast<std::uint32_t>(tint.r) | (static_cast<std::uint32_t>(tint.g) << 8) |
+        (static_cast<std::uint32_t>(tint.b) << 16) | (static_cast<std::uint32_t>(tint.a) << 24);
+    return std::uint64_t{std::bit_cast<std::uint32_t>(mass)} | (std::uint64_t{rgba} << 32);
+}
+
+[[nodiscard]] inline auto unpack_mass(const std::uint64_t attributes) -> float {
+    return std::bit_cast<float>(static_cast<std::uint32_t>(attributes));
+}
+
+[[nodiscard]] inline auto unpack_tint(const std::uint64_t attributes) -> raylib::Color {
+    const auto rgba = static_cast<std::uint32_t>(attributes >> 32);
+    return raylib::Color(static_cast<unsigned char>(rgba), static_cast<unsigned char>(rgba >> 8),
+                         static_cast<unsigned char>(rgba >> 16), static_cast<unsigned char>(rgba >> 24));
+}
+
+// One sampled frame, captured by the simulation thread and encoded by the writer thread.
+struct Frame {
+    std::uint64_t step = 0;
+    double sim_time = 0.0;
+    std::vector<std::uint64_t> ids;
+    std::vector<DVec2> positions;
+    std::vector<DVec2> velocities;
+    std::vector<std::uint64_t> attributes;  // pack_attributes(mass, tint)
+
+    void clear() {
+        ids.clear();
+        positions.clear();
+        velocities.clear();
+        attributes.clear();
+    }
+};
+
+// Byte-oriented zero-run codec. A control byte c < 0x80 is followed by c + 1 literal bytes; c >= 0x80 is a run
+// of (c & 0x7F) + kMinRun zero bytes, and 0xFF continues the run length as a LEB128 varint.
+class ZeroRunCodec {
+public:
+    static void compress(const std::byte* in, const std::size_t n, std::vector<std::byte>& out) {
+        out.clear();
+        out.reserve(n / 4 + 16);
+        std::size_t i = 0;
+        std::size_t literalStart = 0;
+        const auto flush_literals = [&](const std::size_t end) {
+            while (literalStart < end) {
+                const std::size_t len = std::min<std::size_t>(kMaxLiteral, end - literalStart);
+                out.push_back(static_cast<std::byte>(len - 1));
+                out.insert(out.end(), in + literalStart, in + literalStart + len);
+                literalStart += len;
+            }
+        };
+        while (i < n) {
+            if (in[i] != std::byte{0}) {
+                ++i;
+                continue;
+            }
+            std::size_t run = 1;
+            while (i + run < n && in[i + run] == std::byte{0}) ++run;
+            if (run < kMinRun) {
+                i += run;
+                continue;
+            }
+            flush_literals(i);
+            const std::size_t extra = run - kMinRun;
+            if (extra < kLongRun) {
+                out.push_back(static_cast<std::byte>(0x80 | extra));
+            } else {
+                out.push_back(std::byte{0xFF});
+                std::size_t v = extra - kLongRun;
+                do {
+                    const auto b = static_cast<std::uint8_t>(v & 0x7F);
+                    v >>= 7;
+                    out.push_back(static_cast<std::byte>(v ? (b | 0x80) : b));
+                } while (v);
+            }
+            i += run;
+            literalStart = i;
+        }
+        flush_literals(n);
+    }
+
+    // Returns false on malformed input or a size mismatch.
+    static bool decompress(const std::byte* in, const std::size_t n, std::byte* out, const std::size_t rawSize) {
+        std::size_t i = 0;
+        std::size_t o = 0;
+        while (i < n) {
+            const auto c = static_cast<std::uint8_t>(in[i++]);
+            if (c < 0x80) {
+                const std::size_t len = std::size_t{c} + 1;
+                if (n - i < len || rawSize - o < len) return false;
+                std::memcpy(out + o, in + i, len);
+                i += len;
+                o += len;
+                continue;
+            }
+            std::size_t run = kMinRun + (c & 0x7F);
+            if (c == 0xFF) {
+                std::size_t v = 0;
+                int shift = 0;
+                while (true) {
+                    if (i >= n || shift > 56) return false;
+                    const auto b = static_cast<std::uint8_t>(in[i++]);
+                    v |= static_cast<std::size_t>(b & 0x7F) << shift;
+                    shift += 7;
+                    if (!(b & 0x80)) break;
+                }
+                run = kMinRun + kLongRun + v;
+            }
+            if (rawSize - o < run) return false;
+            std::memset(out + o, 0, run);
+            o += run;
+        }
+        return o == rawSize;
+    }
+
+private:
+    static constexpr std::size_t kMaxLiteral = 128;
+    static constexpr std::size_t kMinRun = 3;
+    static constexpr std::size_t kLongRun = 0x7F;  // extra run lengths >= this use the varint form
+};
+
+// Byte shuffle of count 8-byte words: byte k of word i goes to out[k * count + i].
+inline void shuffle8(const std::uint64_t* in, const std::size_t count, std::byte* out) {
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint64_t v = in[i];
+        for (std::size_t k = 0; k < 8; ++k, v >>= 8) out[k * count + i] = static_cast<std::byte>(v & 0xFF);
+    }
+}
+
+inline void unshuffle8(const std::byte* in, const std::size_t count, std::uint64_t* out) {
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint64_t v = 0;
+        for (std::size_t k = 8; k-- > 0;) v = (v << 8) | static_cast<std::uint64_t>(in[k * count + i]);
+        out[i] = v;
+    }
+}
+
+// Streams frames to disk on its own thread. The simulation thread takes a free Frame with acquire(), fills it
+// and hands it back with submit(); when every frame buffer is queued (the disk is behind) acquire() returns
+// nullptr and the caller drops the sample instead of waiting.
+class Writer {
+public:
+    struct Stats {
+        std::atomic<std::uint64_t> frames_written{0};
+        std::atomic<std::uint64_t> frames_dropped{0};
+        std::atomic<std::uint64_t> raw_bytes{0};
+        std::atomic<std::uint64_t> stored_bytes{0};
+        std::atomic<bool> failed{false};
+    };
+
+    Writer() = default;
+    ~Writer() { close(); }
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    // Every keyframeChunks-th chunk opens with a keyframe; the others continue the delta chain of the chunk before.
+    bool open(const std::filesystem::path& path, const std::uint32_t recordInterval, const std::uint32_t framesPerChunk,
+              const std::uint32_t keyframeChunks, const std::size_t queueDepth) {
+        close();
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+        out_.open(path, std::ios::binary | std::ios::trunc);
+        if (!out_) return false;
+        header_ = FileHeader{};
+        header_.record_interval = std::max<std::uint32_t>(1, recordInterval);
+        header_.frames_per_chunk = std::max<std::uint32_t>(1, framesPerChunk);
+        keyframe_chunks_ = std::max<std::uint32_t>(1, keyframeChunks);
+        write_raw(&header_, sizeof(header_));
+        offset_ = sizeof(header_);
+
+        pool_.clear();
+        free_.clear();
+        for (std::size_t i = 0; i < std::max<std::size_t>(1, queueDepth); ++i) {
+            pool_.push_back(std::make_unique<Frame>());
+            free_.push_back(pool_.back().get());
+        }
+        queue_.clear();
+        index_.clear();
+        prev_words_.clear();
+        frames_total_ = 0;
+        stopping_ = false;
+        path_ = path;
+        thread_ = std::thread([this] { run(); });
+        return true;
+    }
+
+    // Flushes the queue and the open chunk, writes the index and footer, and joins the writer thread.
+    void close() {
+        if (!thread_.joinable()) return;
+        {
+            std::scoped_lock lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+        flush_chunk();
+        Footer footer{};
+        footer.index_offset = offset_;
+        footer.chunk_count = index_.size();
+        footer.frame_count = frames_total_;
+        write_raw(index_.data(), index_.size() * sizeof(ChunkIndex));
+        write_raw(&footer, sizeof(footer));
+        out_.close();
+    }
+
+    [[nodiscard]] auto is_open() const -> bool { return thread_.joinable(); }
+    [[nodiscard]] auto path() const -> const std::filesystem::path& { return path_; }
+    [[nodiscard]] auto stats() const -> const Stats& { return stats_; }
+    [[nodiscard]] auto record_interval() const -> std::uint32_t { return header_.record_interval; }
+
+    auto acquire() -> Frame* {
+        std::scoped_lock lock(mutex_);
+        if (free_.empty()) {
+            stats_.frames_dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Frame* f = free_.back();
+        free_.pop_back();
+        f->clear();
+        return f;
+    }
+
+    void submit(Frame* f) {
+        {
+            std::scoped_lock lock(mutex_);
+            queue_.push_back(f);
+        }
+        wake_.notify_one();
+    }
+
+private:
+    std::ofstream out_;
+    std::filesystem::path path_;
+    FileHeader header_{};
+    std::uint64_t offset_ = 0;
+    std::uint32_t keyframe_chunks_ = 1;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<std::unique_ptr<Frame>> pool_;
+    std::vector<Frame*> free_;
+    std::deque<Frame*> queue_;
+    bool stopping_ = false;
+    Stats stats_;
+
+    // Writer-thread state
+    std::vector<ChunkIndex> index_;
+    std::uint64_t frames_total_ = 0;
+    std::vector<FrameHeader> chunk_frames_;
+    std::vector<std::byte> chunk_payload_;
+    std::vector<std::uint64_t> prev_words_;  // previous frame's id/position/velocity words
+    std::vector<std::uint64_t> words_;
+    std::vector<std::byte> raw_;
+    std::vector<std::byte> stored_;
+
+    void run() {
+        while (true) {
+            Frame* f = nullptr;
+            {
+                std::unique_lock lock(mutex_);
+                wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) return;  // stopping and drained
+                f = queue_.front();
+                queue_.pop_front();
+            }
+            append(*f);
+            {
+                std::scoped_lock lock(mutex_);
+                free_.push_back(f);
+            }
+        }
+    }
+
+    void append(const Frame& f) {
+        const std::size_t n = f.ids.size();
+        const bool chunkKey = chunk_frames_.empty() && index_.size() % keyframe_chunks_ == 0;
+        const bool keyframe = chunkKey || prev_words_.size() != n * kWordsPerBody;
+        chunk_frames_.push_back(FrameHeader{f.step, f.sim_time, n, keyframe ? 1U : 0U, 0});
+
+        // Gather the four arrays as words, delta against the previous frame, then shuffle array by array.
+        words_.resize(n * kWordsPerBody);
+        std::memcpy(words_.data(), f.ids.data(), n * sizeof(std::uint64_t));
+        std::memcpy(words_.data() + n, f.positions.data(), n * sizeof(DVec2));
+        std::memcpy(words_.data() + 3 * n, f.velocities.data(), n * sizeof(DVec2));
+        std::memcpy(words_.data() + 5 * n, f.attributes.data(), n * sizeof(std::uint64_t));
+        const std::size_t at = chunk_payload_.size();
+        chunk_payload_.resize(at + words_.size() * sizeof(std::uint64_t));
+        std::byte* dst = chunk_payload_.data() + at;
+        if (!keyframe) {
+            for (std::size_t i = 0; i < words_.size(); ++i) prev_words_[i] ^= words_[i];
+            shuffle_arrays(prev_words_.data(), n, dst);
+        } else {
+            shuffle_arrays(words_.data(), n, dst);
+        }
+        prev_words_.swap(words_);  // the absolute values become the next frame's reference
+
+        ++frames_total_;
+        stats_.frames_written.fetch_add(1, std::memory_order_relaxed);
+        if (chunk_frames_.size() >= header_.frames_per_chunk) flush_chunk();
+    }
+
+    static void shuffle_arrays(const std::uint64_t* words, const std::size_t n, std::byte* dst) {
+        shuffle8(words, n, dst);
+        shuffle8(words + n, 2 * n, dst + n * 8);
+        shuffle8(words + 3 * n, 2 * n, dst + n * 24);
+        shuffle8(words + 5 * n, n, dst + n * 40);
+    }
+
+    void flush_chunk() {
+        if (chunk_frames_.empty()) return;
+        const std::size_t headerBytes = chunk_frames_.size() * sizeof(FrameHeader);
+        raw_.resize(headerBytes + chunk_payload_.size());
+        std::memcpy(raw_.data(), chunk_frames_.data(), headerBytes);
+        std::memcpy(raw_.data() + headerBytes, chunk_payload_.data(), chunk_payload_.size());
+        ZeroRunCodec::compress(raw_.data(), raw_.size(), stored_);
+
+        ChunkPrefix prefix{};
+        prefix.raw_size = raw_.size();
+        prefix.stored_size = stored_.size();
+        prefix.frame_count = static_cast<std::uint32_t>(chunk_frames_.size());
+        ChunkIndex entry{};
+        entry.offset = offset_;
+        entry.stored_size = stored_.size();
+        entry.raw_size = raw_.size();
+        entry.first_frame = frames_total_ - chunk_frames_.size();
+        entry.frame_count = prefix.frame_count;
+        entry.keyframe = chunk_frames_.front().keyframe;
+        entry.first_step = chunk_frames_.front().step;
+        entry.first_time = chunk_frames_.front().sim_time;
+        entry.last_time = chunk_frames_.back().sim_time;
+        write_raw(&prefix, sizeof(prefix));
+        write_raw(stored_.data(), stored_.size());
+        out_.flush();
+        if (!out_) stats_.failed.store(true, std::memory_order_relaxed);
+        index_.push_back(entry);
+        offset_ += sizeof(prefix) + stored_.size();
+        stats_.raw_bytes.fetch_add(raw_.size(), std::memory_order_relaxed);
+        stats_.stored_bytes.fetch_add(stored_.size(), std::memory_order_relaxed);
+
+        // prev_words_ stays: the next chunk deltas against this chunk's last frame unless it is due a keyframe.
+        chunk_frames_.clear();
+        chunk_payload_.clear();
+    }
+
+    void write_raw(const void* p, const std::size_t bytes) {
+        out_.write(static_cast<const char*>(p), static_cast<std::streamsize>(bytes));
+    }
+};
+
+// Random access to a trajectory file through a read-only mapping. frame() decodes only the chunk holding the
+// requested frame, keeps it for neighbouring requests, and has a helper thread decode the next chunk in the
+// direction of travel so steady playback never waits on decompression. A chunk that continues the previous
+// chunk's delta chain needs that chunk's last frame; each decoder keeps the last frame it produced, so forward
+// playback decodes every chunk once, and a seek replays at most record_keyframe_chunks chunks.
+class Reader {
+public:
+    // A decoded frame; the pointers stay valid until the next frame() call.
+    struct FrameView {
+        const FrameHeader* header = nullptr;
+        const std::uint64_t* words = nullptr;  // ids[n], positions[2n], velocities[2n], attributes[n]
+
+        [[nodiscard]] auto body_count() const -> std::size_t { return static_cast<std::size_t>(header->body_count); }
+        [[nodiscard]] auto ids() const -> const std::uint64_t* { return words; }
+        [[nodiscard]] auto position_words() const -> const std::uint64_t* { return words + body_count(); }
+        [[nodiscard]] auto velocity_words() const -> const std::uint64_t* { return words + 3 * body_count(); }
+        [[nodiscard]] auto attributes() const -> const std::uint64_t* { return words + 5 * body_count(); }
+    };
+
+    Reader() = default;
+    ~Reader() { close(); }
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    bool open(const std::filesystem::path& path) {
+        close();
+        if (!file_.open(path)) return false;
+        const std::byte* base = file_.data();
+        const std::size_t size = file_.size();
+        if (size < sizeof(FileHeader)) return fail();
+        std::memcpy(&header_, base, sizeof(header_));
+        if (header_.magic != kMagic || header_.version != kVersion || header_.endian != kEndianMark ||
+            header_.codec != kCodecZeroRun || header_.header_size < sizeof(FileHeader) || header_.header_size > size)
+            return fail();
+        if (!read_index() && !scan_chunks()) return fail();
+        for (const ChunkIndex& e : index_) frames_ += e.frame_count;
+        path_ = path;
+        prefetcher_ = std::thread([this] { prefetch_loop(); });
+        return true;
+    }
+
+    void close() {
+        if (prefetcher_.joinable()) {
+            {
+                std::scoped_lock lock(mutex_);
+                stopping_ = true;
+            }
+            wake_.notify_all();
+            prefetcher_.join();
+        }
+        stopping_ = false;
+        want_ = kNoChunk;
+        busy_ = false;
+        current_.index = kNoChunk;
+        ready_.index = kNoChunk;
+        staging_.index = kNoChunk;
+        tail_.chunk = kNoChunk;
+        prefetch_tail_.chunk = kNoChunk;
+        index_.clear();
+        frames_ = 0;
+        last_chunk_ = kNoChunk;
+        path_.clear();
+        file_.close();
+    }
+
+    [[nodiscard]] auto is_open() const -> bool { return file_.is_open(); }
+    [[nodiscard]] auto path() const -> const std::filesystem::path& { return path_; }
+    [[nodiscard]] auto frame_count() const -> std::uint64_t { return frames_; }
+    [[nodiscard]] auto chunks() const -> const std::vector<ChunkIndex>& { return index_; }
+    [[nodiscard]] auto record_interval() const -> std::uint32_t { return header_.record_interval; }
+    [[nodiscard]] auto file_size() const -> std::size_t { return file_.size(); }
+
+    // Decode frame i (0-based); false if it is out of range or its chunk is corrupt.
+    bool frame(const std::uint64_t i, FrameView& out) {
+        if (i >= frames_) return false;
+        const std::uint64_t c = chunk_of(i);
+        if (current_.index != c && !take_prefetched(c)) {
+            if (!decode(c, current_, scratch_, tail_)) return false;
+        }
+        // Prefetch the neighbour in the direction of travel and ask the OS to page in the one after it.
+        const std::int64_t direction = (last_chunk_ != kNoChunk && c < last_chunk_) ? -1 : 1;
+        last_chunk_ = c;
+        const auto neighbour = [&](const std::int64_t distance) {
+            const std::int64_t k = static_cast<std::int64_t>(c) + distance * direction;
+            return (k >= 0 && static_cast<std::uint64_t>(k) < index_.size()) ? static_cast<std::uint64_t>(k) : kNoChunk;
+        };
+        if (const std::uint64_t next = neighbour(1); next != kNoChunk) request(next);
+        if (const std::uint64_t ahead = neighbour(2); ahead != kNoChunk) {
+            const ChunkIndex& e = index_[static_cast<std::size_t>(ahead)];
+            file_.will_need(static_cast<std::size_t>(e.offset),
+                            sizeof(ChunkPrefix) + static_cast<std::size_t>(e.stored_size));
+        }
+        const std::size_t local = static_cast<std::size_t>(i - index_[c].first_frame);
+        out.header = &current_.frames[local];
+        out.words = current_.words.data() + current_.offsets[local];
+        return true;
+    }
+
+private:
+    static constexpr std::uint64_t kNoChunk = ~std::uint64_t{0};
+    static constexpr std::uint64_t kMaxRawChunk = std::uint64_t{1} << 34;  // sanity bound for corrupt sizes
+
+    // One decoded chunk: frame headers and each frame's absolute (un-delta'd) words.
+    struct Chunk {
+        std::uint64_t index = kNoChunk;
+        std::vector<FrameHeader> frames;
+        std::vector<std::size_t> offsets;  // of each frame in words
+        std::vector<std::uint64_t> words;
+    };
+
+    // Absolute words of the last frame of a decoded chunk: the delta base for the chunk after it.
+    struct Tail {
+        std::uint64_t chunk = kNoChunk;
+        std::uint64_t body_count = 0;
+        std::vector<std::uint64_t> words;
+    };
+
+    MappedFile file_;
+    std::filesystem::path path_;
+    FileHeader header_{};
+    std::vector<ChunkIndex> index_;
+    std::uint64_t frames_ = 0;
+    std::uint64_t last_chunk_ = kNoChunk;
+    Chunk current_;
+    std::vector<std::byte> scratch_;
+    Tail tail_;
+
+    // Prefetch: the caller sets want_; the helper decodes it into staging_ and swaps it into ready_.
+    std::thread prefetcher_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::uint64_t want_ = kNoChunk;
+    bool busy_ = false;
+    bool stopping_ = false;
+    Chunk ready_;
+    Chunk staging_;
+    std::vector<std::byte> prefetch_scratch_;
+    Tail prefetch_tail_;
+
+    bool fail() {
+        file_.close();
+        return false;
+    }
+
+    [[nodiscard]] auto chunk_of(const std::uint64_t frame) const -> std::uint64_t {
+        const auto it = std::upper_bound(index_.begin(), index_.end(), frame,
+                                         [](const std::uint64_t f, const ChunkIndex& e) { return f < e.first_frame; });
+        return static_cast<std::uint64_t>(it - index_.begin()) - 1;
+    }
+
+    // Index and footer written by Writer::close().
+    bool read_index() {
+        const std::byte* base = file_.data();
+        const std::size_t size = file_.size();
+        if (size < header_.header_size + sizeof(Footer)) return false;
+        Footer footer{};
+        std::memcpy(&footer, base + size - sizeof(Footer), sizeof(footer));
+        const std::size_t indexEnd = size - sizeof(Footer);
+        if (footer.magic != kFooterMagic || footer.index_offset > indexEnd ||
+            footer.chunk_count != (indexEnd - footer.index_offset) / sizeof(ChunkIndex))
+            return false;
+        index_.resize(static_cast<std::size_t>(footer.chunk_count));
+        std::memcpy(index_.data(), base + footer.index_offset, index_.size() * sizeof(ChunkIndex));
+        std::uint64_t expected = 0;
+        for (const ChunkIndex& e : index_) {
+            const bool inside = e.offset <= footer.index_offset &&
+                sizeof(ChunkPrefix) <= footer.index_offset - e.offset &&
+                e.stored_size <= footer.index_offset - e.offset - sizeof(ChunkPrefix);
+            if (e.first_frame != expected || !inside) {
+                index_.clear();
+                return false;
+            }
+            expected += e.frame_count;
+        }
+        return true;
+    }
+
+    // Recording cut short (no footer): walk the chunk prefixes and rebuild the index from the frame headers.
+    bool scan_chunks() {
+        index_.clear();
+        const std::byte* base = file_.data();
+        const std::size_t size = file_.size();
+        std::uint64_t at = header_.header_size;
+        std::uint64_t frames = 0;
+        Chunk probe;
+        while (size - at >= sizeof(ChunkPrefix)) {
+            ChunkPrefix prefix{};
+            std::memcpy(&prefix, base + at, sizeof(prefix));
+            if (prefix.magic != kChunkMagic || prefix.stored_size > size - at - sizeof(ChunkPrefix)) break;
+            ChunkIndex e{};
+            e.offset = at;
+            e.stored_size = prefix.stored_size;
+            e.raw_size = prefix.raw_size;
+            e.first_frame = frames;
+            e.frame_count = prefix.frame_count;
+            index_.push_back(e);
+            // Chunks are decoded in order here, so tail_ always holds the previous chunk's last frame.
+            if (!decode_one(index_.size() - 1, probe, scratch_, tail_) || probe.frames.empty()) {
+                index_.pop_back();
+                break;  // torn final chunk
+            }
+            index_.back().keyframe = probe.frames.front().keyframe;
+            index_.back().first_step = probe.frames.front().step;
+            index_.back().first_time = probe.frames.front().sim_time;
+            index_.back().last_time = probe.frames.back().sim_time;
+            frames += prefix.frame_count;
+            at += sizeof(ChunkPrefix) + prefix.stored_size;
+        }
+        return !index_.empty();
+    }
+
+    // Decode chunk c, first replaying chunks from the nearest keyframe chunk when tail does not already hold chunk
+    // c - 1. Thread-safe for distinct out/raw/tail buffers.
+    bool decode(const std::uint64_t c, Chunk& out, std::vector<std::byte>& raw, Tail& tail) const {
+        if (c > 0 && !index_[static_cast<std::size_t>(c)].keyframe && tail.chunk != c - 1) {
+            std::uint64_t from = c - 1;
+            while (from > 0 && !index_[static_cast<std::size_t>(from)].keyframe) --from;
+            if (tail.chunk != kNoChunk && tail.chunk >= from && tail.chunk < c) from = tail.chunk + 1;
+            for (std::uint64_t k = from; k < c; ++k) {
+                if (!decode_one(k, out, raw, tail)) return false;
+            }
+        }
+        return decode_one(c, out, raw, tail);
+    }
+
+    // Decompress chunk c and rebuild absolute words for every frame; tail must hold chunk c - 1 unless c starts
+    // with a keyframe, and holds chunk c afterwards.
+    bool decode_one(const std::uint64_t c, Chunk& out, std::vector<std::byte>& raw, Tail& tail) const {
+        out.index = kNoChunk;
+        const ChunkIndex& e = index_[static_cast<std::size_t>(c)];
+        ChunkPrefix prefix{};
+        std::memcpy(&prefix, file_.data() + e.offset, sizeof(prefix));
+        if (prefix.magic != kChunkMagic || prefix.raw_size != e.raw_size || prefix.stored_size != e.stored_size ||
+            prefix.frame_count != e.frame_count || prefix.raw_size > kMaxRawChunk ||
+            prefix.raw_size < std::uint64_t{prefix.frame_count} * sizeof(FrameHeader))
+            return false;
+        raw.resize(static_cast<std::size_t>(prefix.raw_size));
+        if (!ZeroRunCodec::decompress(file_.data() + e.offset + sizeof(ChunkPrefix),
+                                      static_cast<std::size_t>(prefix.stored_size), raw.data(), raw.size()))
+            return false;
+
+        out.frames.resize(prefix.frame_count);
+        std::memcpy(out.frames.data(), raw.data(), out.frames.size() * sizeof(FrameHeader));
+        std::size_t payload = raw.size() - out.frames.size() * sizeof(FrameHeader);
+        std::size_t totalWords = 0;
+        for (const FrameHeader& h : out.frames) {
+            const std::uint64_t bytes = h.body_count * kWordsPerBody * sizeof(std::uint64_t);
+            if (h.body_count > payload || bytes > payload) return false;
+            payload -= static_cast<std::size_t>(bytes);
+            totalWords += static_cast<std::size_t>(h.body_count) * kWordsPerBody;
+        }
+        if (payload != 0) return false;
+
+        out.offsets.resize(out.frames.size());
+        out.words.resize(totalWords);
+        const std::byte* src = raw.data() + out.frames.size() * sizeof(FrameHeader);
+        std::size_t at = 0;
+        for (std::size_t f = 0; f < out.frames.size(); ++f) {
+            const FrameHeader& h = out.frames[f];
+            const auto n = static_cast<std::size_t>(h.body_count);
+            const std::size_t count = n * kWordsPerBody;
+            const bool chained = f == 0 && c > 0 && tail.chunk == c - 1 && tail.body_count == h.body_count;
+            if (!h.keyframe && !chained && (f == 0 || out.frames[f - 1].body_count != h.body_count)) return false;
+            std::uint64_t* dst = out.words.data() + at;
+            unshuffle8(src, n, dst);
+            unshuffle8(src + n * 8, 2 * n, dst + n);
+            unshuffle8(src + n * 24, 2 * n, dst + 3 * n);
+            unshuffle8(src + n * 40, n, dst + 5 * n);
+            if (!h.keyframe) {
+                const std::uint64_t* prev = (f == 0) ? tail.words.data() : dst - count;
+                for (std::size_t k = 0; k < count; ++k) dst[k] ^= prev[k];
+            }
+            out.offsets[f] = at;
+            at += count;
+            src += count * sizeof(std::uint64_t);
+        }
+        out.index = c;
+        if (!out.frames.empty()) {
+            const std::size_t last = out.frames.size() - 1;
+            tail.chunk = c;
+            tail.body_count = out.frames[last].body_count;
+            tail.words.assign(out.words.begin() + static_cast<std::ptrdiff_t>(out.offsets[last]), out.words.end());
+        }
+        return true;
+    }
+
+    // Use the prefetched chunk if it is c, waiting for it when the helper is still decoding c.
+    bool take_prefetched(const std::uint64_t c) {
+        std::unique_lock lock(mutex_);
+        if (want_ == c) idle_.wait(lock, [this] { return !busy_; });
+        if (ready_.index != c) return false;
+        std::swap(current_, ready_);
+        return true;
+    }
+
+    void request(const std::uint64_t c) {
+        {
+            std::scoped_lock lock(mutex_);
+            if (want_ == c || ready_.index == c || current_.index == c) return;
+            want_ = c;
+        }
+        wake_.notify_one();
+    }
+
+    void prefetch_loop() {
+        std::unique_lock lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [this] { return stopping_ || (want_ != kNoChunk && ready_.index != want_); });
+            if (stopping_) return;
+            const std::uint64_t c = want_;
+            busy_ = true;
+            lock.unlock();
+            const bool ok = decode(c, staging_, prefetch_scratch_, prefetch_tail_);
+            lock.lock();
+            if (ok) std::swap(ready_, staging_);
+            if (!ok || want_ == c) want_ = kNoChunk;
+            busy_ = false;
+            idle_.notify_all();
+        }
+    }
+};
+
+}  // namespace trajectory
+}  // namespace nbody
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace nbody {
+
+// Lock-free single-producer / single-consumer triple buffer.
+// The producer fills write_buffer() and calls publish(); the consumer calls update() to grab the most
+// recently published buffer and then reads read_buffer(). Neither side ever blocks or waits on the other:
+// the producer always has a private buffer to write into and the consumer always keeps a stable one to read.
+template <typename T>
+class TripleBuffer {
+public:
+    // Producer side
+    [[nodiscard]] auto write_buffer() -> T& { return buffers_[back_]; }
+
+    void publish() {
+        const std::uint8_t prev = middle_.exchange(static_cast<std::uint8_t>(back_ | kDirty), std::memory_order_acq_rel);
+        back_ = static_cast<std::uint8_t>(prev & kIndexMask);
+    }
+
+    // Consumer side: returns true if a newer buffer was swapped in.
+    auto update() -> bool {
+        if ((middle_.load(std::memory_order_relaxed) & kDirty) == 0) return false;
+        const std::uint8_t prev = middle_.exchange(front_, std::memory_order_acq_rel);
+        front_ = static_cast<std::uint8_t>(prev & kIndexMask);
+        return true;
+    }
+
+    [[nodiscard]] auto read_buffer() const -> const T& { return buffers_[front_]; }
+
+private:
+    static constexpr std::uint8_t kIndexMask = 0x3;
+    static constexpr std::uint8_t kDirty = 0x4;
+
+    std::array<T, 3> buffers_{};
+    std::atomic<std::uint8_t> middle_{1};
+    std::uint8_t back_ = 0;   // owned by the producer
+    std::uint8_t front_ = 2;  // owned by the consumer
+};
+
+}  // namespace nbody
@@ -1,21 +1,41 @@
 #include <algorithm>
 #include <array>
+#include <charconv>
 #include <cmath>
+#include <cstdint>
+#include <filesystem>
 #include <flecs.h>
 #include <imgui.h>
 #include <raylib-cpp.hpp>
 #include <raylib.h>
 #include <raymath.h>
 #include <rlImGui.h>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
 
 #include "components/Components.hpp"
 #include "core/Config.hpp"
+#include "core/AllocationCounter.hpp"
 #include "core/Constants.hpp"
+#include "core/Generators.hpp"
+#include "core/Profiler.hpp"
+#include "core/RenderSnapshot.hpp"
+#include "physics/Calibration.hpp"
 
 // New header-only systems
+#include "systems/AllocationCheck.hpp"
 #include "systems/Camera.hpp"
+#include "systems/Checkpointer.hpp"
+#include "systems/Governor.hpp"
 #include "systems/Interaction.hpp"
 #include "systems/Physics.hpp"
+#include "systems/Playback.hpp"
+#include "systems/Recorder.hpp"
+#include "systems/Simulation.hpp"
+#include "systems/TraceCapture.hpp"
 #include "systems/UI.hpp"
 #include "systems/WorldRenderer.hpp"
 
@@ -26,13 +46,14 @@ void create_initial_bodies(const flecs::world& world) {
                         const bool pinned) {
         world.entity()
             .set<Position>({dvec2(pos)})
+            .set<PrevPosition>({dvec2(pos)})
             .set<Velocity>({dvec2(vel)})
             .set<Acceleration>({DVec2{0.0, 0.0}})
             .set<PrevAcceleration>({DVec2{0.0, 0.0}})
             .set<Mass>({mass})
             .set<Pinned>({pinned})
             .set<Tint>({col})
-            .set<Trail>({{}})
+            .set<Trail>({})
             .add<Selectable>()  // Make all bodies selectable
             .set<Draggable>({.can_drag_velocity = true, .drag_scale = nbody::constants::drag_vel_scale});  // Make all bodies draggable
     };
@@ -54,34 +75,136 @@ void create_initial_bodies(const flecs::world& world) {
 }
 }  // namespace scenario
 
+// Command line:
+//   --restart [checkpoint]  resume from a checkpoint (default: the latest periodic one)
+//   --generate <model>      start from generated bodies: plummer, disk, collapse or collide
+//   --bodies N, --seed S    generator parameters (imply --generate plummer)
+struct Options {
+    std::optional<std::filesystem::path> restart;
+    std::optional<nbody::Generators::Params> generate;
+    std::optional<int> trace_frames;  // capture a Chrome trace of the first N frames
+    std::filesystem::path trace_out;  // empty: TraceCapture picks a file under traces_dir()
+    std::optional<int> alloc_check;  // zero-allocation test mode: frames to check after warm-up
+};
+
+inline constexpr std::string_view kUsage =
+    "usage: raylib_nbody [--restart [checkpoint]] [--generate plummer|disk|collapse|collide] [--bodies N] [--seed S] "
+    "[--trace FRAMES] [--trace-out FILE] [--alloc-check [FRAMES]]";
+
+auto parse_options(const int argc, char** argv) -> Options {
+    Options options;
+    const auto fail = [](const std::string& why) {
+        throw std::invalid_argument(why + " (" + std::string(kUsage) + ")");
+    };
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--restart") {
+            const bool hasPath = i + 1 < argc && argv[i + 1][0] != '-';
+            options.restart = hasPath ? std::filesystem::path(argv[++i]) : nbody::Checkpointer::latest_path();
+        } else if (arg == "--generate" || arg == "--bodies" || arg == "--seed") {
+            if (i + 1 >= argc) fail(std::string(arg) + " needs a value");
+            const std::string_view value = argv[++i];
+            auto& params = options.generate ? *options.generate : options.generate.emplace();
+            if (arg == "--generate") {
+                const auto kind = nbody::Generators::parse(value);
+                if (!kind) fail("unknown model " + std::string(value));
+                params.kind = *kind;
+                continue;
+            }
+            std::uint64_t number = 0;
+            const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), number);
+            if (ec != std::errc{} || end != value.data() + value.size()) fail("bad number " + std::string(value));
+            if (arg == "--seed") {
+                params.seed = number;
+            } else {
+                if (number == 0 || number > static_cast<std::uint64_t>(nbody::constants::generator_bodies_max))
+                    fail("--bodies must be 1.." + std::to_string(nbody::constants::generator_bodies_max));
+                params.count = static_cast<std::size_t>(number);
+            }
+        } else if (arg == "--trace") {
+            if (i + 1 >= argc) fail("--trace needs a frame count");
+            const std::string_view value = argv[++i];
+            int frames = 0;
+            const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), frames);
+            if (ec != std::errc{} || end != value.data() + value.size() || frames <= 0 ||
+                frames > nbody::constants::trace_frames_max)
+                fail("--trace must be 1.." + std::to_string(nbody::constants::trace_frames_max));
+            options.trace_frames = frames;
+        } else if (arg == "--alloc-check") {
+            options.alloc_check = nbody::constants::default_alloc_check_frames;
+            if (i + 1 >= argc || argv[i + 1][0] == '-') continue;
+            const std::string_view value = argv[++i];
+            int frames = 0;
+            const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), frames);
+            if (ec != std::errc{} || end != value.data() + value.size() || frames <= 0 ||
+                frames > nbody::constants::alloc_check_frames_max)
+                fail("--alloc-check must be 1.." + std::to_string(nbody::constants::alloc_check_frames_max));
+            options.alloc_check = frames;
+        } else if (arg == "--trace-out") {
+            if (i + 1 >= argc) fail("--trace-out needs a path");
+            options.trace_out = argv[++i];
+        } else {
+            fail("unknown option " + std::string(arg));
+        }
+    }
+    if (options.restart && options.generate) fail("--restart cannot be combined with generator options");
+    if (!options.trace_out.empty() && !options.trace_frames)
+        options.trace_frames = nbody::constants::default_trace_frames;
+    return options;
+}
+
 class Application {
 public:
-    Application() {
+    explicit Application(const Options& options) {
         SetConfigFlags(FLAG_WINDOW_HIGHDPI | FLAG_MSAA_4X_HINT);
         // Initialize window after setting flags
         InitWindow(nbody::constants::window_width, nbody::constants::window_height, "N-Body Gravity Simulation • ECS");
         SetTargetFPS(nbody::constants::target_fps);
         rlImGuiSetup(true);
+        nbody::Profiler::name_thread("Main");
 
-        initialize_world();
+        initialize_world(!options.restart && !options.generate);
+        if (options.restart) restore_checkpoint(*options.restart);
+        if (options.generate) {
+            nbody::Generators::apply(world_, *options.generate);
+            nbody::Camera::center_on_center_of_mass(world_);
+        }
+        // Measure (or load the cached) direct/Barnes-Hut crossover in the background; update() hands the result to
+        // the simulation. A restarted run keeps the checkpointed threshold so it continues exactly as it would have.
+        if (const auto* cfg = world_.get<Config>(); cfg && cfg->calibrate_bh_on_startup && !options.restart) {
+            nbody::Calibration::start(world_, false);
+        }
+        sim_.start();
+        if (options.trace_frames) nbody::TraceCapture::start(*options.trace_frames, options.trace_out);
+        if (options.alloc_check) nbody::AllocationCheck::start(*options.alloc_check);
     }
 
     ~Application() {
+        sim_.stop();
+        nbody::Recorder::stop(world_);
+        nbody::Playback::close();
+        nbody::systems::WorldRenderer::shutdown();
         rlImGuiShutdown();
         CloseWindow();
     }
 
-    void run() {
-        while (!WindowShouldClose()) {
+    // Returns the process exit code: 1 when an --alloc-check run saw steady-state allocations.
+    auto run() -> int {
+        while (!WindowShouldClose() && !nbody::AllocationCheck::finished()) {
             update();
             render();
         }
+        return nbody::AllocationCheck::failed() ? 1 : 0;
     }
 
 private:
     flecs::world world_;
+    nbody::Simulation sim_{world_};
+    // Main-thread copies taken while holding the world, used for drawing without it
+    raylib::Camera2D view_camera_{};
+    nbody::Interaction::State overlay_state_{};
 
-    void initialize_world() const {
+    void initialize_world(const bool withInitialBodies) const {
         // Initialize singleton components
         world_.set<Config>({});
 
@@ -89,28 +212,41 @@ private:
         nbody::Physics::register_systems(world_);
         nbody::Camera::register_systems(world_);
         nbody::Interaction::register_systems(world_);
+        nbody::Governor::register_systems(world_);
 
         // Create initial scenario
-        scenario::create_initial_bodies(world_);
+        if (withInitialBodies) scenario::create_initial_bodies(world_);
 
         // Center camera to initial COM
         nbody::Camera::center_on_center_of_mass(world_);
     }
 
-    void update() const {
-        const double frameStart = GetTime();
+    void restore_checkpoint(const std::filesystem::path& path) {
+        std::uint64_t step = 0;
+        double simTime = 0.0;
+        if (!nbody::Checkpointer::restore(world_, path, step, simTime)) {
+            throw std::runtime_error("cannot restore checkpoint " + path.string());
+        }
+        sim_.restore_clock(step, simTime);
+        nbody::Camera::center_on_center_of_mass(world_);
+    }
+
+    void update() {
+        // UI and input touch the world between simulation steps; physics runs on the simulation thread.
+        auto lock = sim_.lock_world();
 
         // Get camera and configuration
         raylib::Camera2D* camera = nbody::Camera::get(world_);
-        auto* cfg = world_.get_mut<Config>();
-
-        if (cfg == nullptr || camera == nullptr) {
+        if (world_.get<Config>() == nullptr || camera == nullptr) {
             return;
         }
 
         // UI first (this sets up ImGui state)
-        nbody::UI::begin();
-        nbody::UI::draw(world_, *camera);
+        {
+            nbody::Profiler::Scope timer(nbody::Profiler::Stage::UI);
+            nbody::UI::begin();
+            nbody::UI::draw(world_, *camera);
+        }
 
         // Check if UI wants to capture mouse
         const ImGuiIO& imguiIO = ImGui::GetIO();
@@ -124,51 +260,50 @@ private:
             }
         }
 
-        // Calculate unscaled delta time for physics; Physics system applies timeScale
-        const float deltaTime = (cfg->use_fixed_dt ? cfg->fixed_dt : GetFrameTime());
-
         // Process interaction input every frame so it can always
         // detect right-button release even if UI captures the mouse.
         // Internally, it early-returns for most actions when UI blocks.
         nbody::Interaction::process_input(world_, *camera);
 
-        // Progress ECS world (runs physics and other systems)
-        if (!cfg->paused) {
-            [[maybe_unused]] auto progress = world_.progress(deltaTime);
+        nbody::Playback::update(world_, GetFrameTime());
+        if (const auto calibration = nbody::Calibration::poll()) {
+            nbody::Simulation::submit(world_, [st = *calibration](const flecs::world& w) {
+                nbody::Calibration::adopt(w, st);
+            });
         }
-
-        // Track frame timing
-        constexpr double kMsPerSec = 1000.0;
-        cfg->last_step_ms = (GetTime() - frameStart) * kMsPerSec;
+        view_camera_ = *camera;
+        if (const auto* state = world_.get<nbody::Interaction::State>()) overlay_state_ = *state;
     }
 
     void render() {
-        BeginDrawing();
-        ClearBackground(nbody::constants::background);
+        const nbody::RenderSnapshot& snapshot =
+            nbody::Playback::active() ? nbody::Playback::snapshot() : sim_.latest_snapshot();
+        const double alpha = snapshot.interpolation_alpha(nbody::RenderSnapshot::Clock::now());
 
-        // Get camera for rendering
-        raylib::Camera2D* camera = nbody::Camera::get(world_);
-        if (camera == nullptr) {
-            nbody::UI::end();
-            EndDrawing();
-            return;
-        }
+        BeginDrawing();
+        {
+            nbody::Profiler::Scope timer(nbody::Profiler::Stage::Render);
+            ClearBackground(nbody::constants::background);
 
-        // Get configuration for rendering
-        if (const auto* cfg = world_.get<Config>()) {
-            // Render the physics scene
-            nbody::systems::WorldRenderer::render_scene(world_, *cfg, *camera);
-        }
+            // Render the physics scene from the latest published snapshot
+            nbody::systems::WorldRenderer::render_scene(snapshot, alpha, view_camera_);
 
-        // Render interaction overlays (selection rings, drag visuals)
-        nbody::Interaction::render_overlay(world_, *camera);
+            // Render interaction overlays (selection rings, drag visuals)
+            nbody::Interaction::render_overlay(snapshot, alpha, overlay_state_, view_camera_);
 
-        // Debug HUD for camera/DPI diagnostics
-        render_debug_hud(*camera);
+            // Debug HUD for camera/DPI diagnostics
+            render_debug_hud(view_camera_);
+        }
 
         // End UI frame and drawing (UI was started in Update)
-        nbody::UI::end();
+        {
+            nbody::Profiler::Scope timer(nbody::Profiler::Stage::UI);
+            nbody::UI::end();
+        }
         EndDrawing();
+        nbody::Profiler::end_frame();
+        nbody::TraceCapture::update();
+        nbody::AllocationCheck::update();
     }
 
     static void render_debug_hud(const raylib::Camera2D& cam) {
@@ -193,11 +328,10 @@ private:
     }
 };
 
-auto main() -> int {
+auto main(int argc, char** argv) -> int {
     try {
-        Application app;
-        app.run();
-        return 0;
+        Application app(parse_options(argc, argv));
+        return app.run();
     } catch (const std::exception& e) {
         TraceLog(LOG_ERROR, "Exception: %s", e.what());
         return 1;
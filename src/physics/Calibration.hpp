@@ -0,0 +1,227 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <flecs.h>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <numbers>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#include "../core/Config.hpp"
+#include "../core/Constants.hpp"
+#include "Gravity.hpp"
+
+namespace nbody {
+
+// Measures where Barnes-Hut starts beating direct summation on this machine and stores it in
+// Config::bh_threshold. Results are cached on disk keyed by host, thread count, build type and theta,
+// so only the first run on a machine pays for the micro-benchmarks.
+// The measurement uses its own synthetic arrays, so it runs on a background task and never holds the world:
+// start() launches it from the main thread, poll() hands back the result once, and the caller applies it with
+// adopt() on the simulation thread.
+class Calibration {
+public:
+    struct Status {
+        int threshold = constants::default_bh_threshold;
+        bool from_cache = false;
+        bool done = false;
+        double seconds = 0.0;  // time spent measuring (0 when cached)
+    };
+
+    // Look up the cached crossover for the current theta in the background, measuring it first if needed (or if
+    // force is set). Reads Config, so call it while holding the world; ignored while a run is in flight.
+    static void start(const flecs::world& w, const bool force) {
+        const auto* cfg = w.get<Config>();
+        if (!cfg || running()) return;
+        const double theta = static_cast<double>(cfg->bh_theta);
+        const double eps2 = static_cast<double>(cfg->softening) * static_cast<double>(cfg->softening);
+        s_task = std::async(std::launch::async,
+                            [theta, G = cfg->g, eps2, force] { return run(theta, G, eps2, force); });
+    }
+
+    [[nodiscard]] static bool running() { return s_task.valid(); }
+
+    // Main thread, once per frame: the finished result, exactly once.
+    [[nodiscard]] static std::optional<Status> poll() {
+        if (!s_task.valid() || s_task.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return std::nullopt;
+        }
+        return s_task.get();
+    }
+
+    // Store a finished result in the world (simulation thread, via Simulation::submit).
+    static void adopt(const flecs::world& w, const Status& st) {
+        if (auto* cfg = w.get_mut<Config>()) cfg->bh_threshold = st.threshold;
+        w.set<Status>(st);
+    }
+
+    // Smallest body count at which Barnes-Hut is faster than direct summation, as the geometric mean
+    // over a uniform disk and a centrally concentrated (Plummer-like) distribution.
+    static int measure_crossover(const double theta, const double G, const double eps2) {
+        const double uniform = crossover_for(false, theta, G, eps2);
+        const double clustered = crossover_for(true, theta, G, eps2);
+        return std::max(1, static_cast<int>(std::lround(std::sqrt(uniform * clustered))));
+    }
+
+    static std::filesystem::path cache_path() {
+        std::filesystem::path base;
+#if defined(_WIN32)
+        if (const char* local = std::getenv("LOCALAPPDATA")) base = local;
+#else
+        if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && xdg[0] != '\0') {
+            base = xdg;
+        } else if (const char* home = std::getenv("HOME")) {
+            base = std::filesystem::path(home) / ".cache";
+        }
+#endif
+        if (base.empty()) base = std::filesystem::temp_directory_path();
+        return base / "raylib-nbody" / "bh_calibration.txt";
+    }
+
+private:
+    static constexpr int kMinBodies = 16;
+    static constexpr int kMaxBodies = 8192;
+    static constexpr double kGrowth = 1.5;
+    static constexpr int kMinReps = 3;
+    static constexpr int kMaxReps = 50;
+    static constexpr double kMinSampleSeconds = 0.005;
+    static constexpr std::uint32_t kSeed = 12345;
+    static constexpr double kExtent = 1.0e9;  // meters; scale is irrelevant to timing but keeps values sane
+    static constexpr float kBodyMass = 1.0e22F;
+
+    static inline std::future<Status> s_task;
+
+    static Status run(const double theta, const double G, const double eps2, const bool force) {
+        const std::string key = machine_key(theta);
+        Status st{};
+        if (const auto cached = force ? std::nullopt : load_cached(key)) {
+            st.threshold = *cached;
+            st.from_cache = true;
+        } else {
+            const auto start = std::chrono::steady_clock::now();
+            st.threshold = measure_crossover(theta, G, eps2);
+            st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            store(key, st.threshold);
+        }
+        st.done = true;
+        return st;
+    }
+
+    static double crossover_for(const bool clustered, const double theta, const double G, const double eps2) {
+        double lastDirectWin = 0.0;
+        for (double nf = kMinBodies; nf <= kMaxBodies; nf *= kGrowth) {
+            const auto n = static_cast<size_t>(nf);
+            std::vector<DVec2> positions;
+            std::vector<float> masses(n, kBodyMass);
+            std::vector<uint8_t> pins(n, 0);
+            std::vector<DVec2> acc(n);
+            generate(clustered, n, positions);
+
+            const double direct = best_seconds([&] {
+                std::fill(acc.begin(), acc.end(), DVec2{0.0, 0.0});
+                Gravity::direct(positions, masses, pins, G, eps2, acc);
+            });
+            const double bh = best_seconds([&] {
+                std::fill(acc.begin(), acc.end(), DVec2{0.0, 0.0});
+                Gravity::barnes_hut(positions, masses, pins, G, eps2, theta, acc);
+            });
+            if (bh < direct) return (lastDirectWin > 0.0) ? std::sqrt(lastDirectWin * nf) : nf;
+            lastDirectWin = nf;
+        }
+        return kMaxBodies;
+    }
+
+    static void generate(const bool clustered, const size_t n, std::vector<DVec2>& out) {
+        std::mt19937 rng(kSeed);
+        std::uniform_real_distribution<double> uni(0.0, 1.0);
+        out.resize(n);
+        for (auto& p : out) {
+            const double u = std::max(uni(rng), 1e-9);
+            // Uniform disk: r ~ sqrt(u). Plummer: r = a / sqrt(u^(-2/3) - 1), capped to keep the box bounded.
+            const double r = clustered ? std::min(kExtent, 0.1 * kExtent / std::sqrt(std::pow(u, -2.0 / 3.0) - 1.0))
+                                       : kExtent * std::sqrt(u);
+            const double a = 2.0 * std::numbers::pi * uni(rng);
+            p = DVec2{r * std::cos(a), r * std::sin(a)};
+        }
+    }
+
+    template <typename F>
+    static double best_seconds(F&& fn) {
+        double best = std::numeric_limits<double>::max();
+        double total = 0.0;
+        for (int rep = 0; rep < kMaxReps && (rep < kMinReps || total < kMinSampleSeconds); ++rep) {
+            const auto t0 = std::chrono::steady_clock::now();
+            fn();
+            const double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            best = std::min(best, dt);
+            total += dt;
+        }
+        return best;
+    }
+
+    static std::string machine_key(const double theta) {
+        std::string host = "unknown";
+#if defined(_WIN32)
+        if (const char* name = std::getenv("COMPUTERNAME")) host = name;
+#else
+        std::array<char, 256> buf{};
+        if (gethostname(buf.data(), buf.size() - 1) == 0 && buf[0] != '\0') host = buf.data();
+#endif
+#if defined(NDEBUG)
+        const char* build = "release";
+#else
+        const char* build = "debug";
+#endif
+        std::array<char, 32> thetaBuf{};
+        std::snprintf(thetaBuf.data(), thetaBuf.size(), "%.2f", theta);
+        std::ostringstream key;
+        key << host << '|' << std::thread::hardware_concurrency() << '|' << build << '|' << thetaBuf.data();
+        return key.str();
+    }
+
+    static std::optional<int> load_cached(const std::string& key) {
+        std::ifstream in(cache_path());
+        std::string k;
+        int value = 0;
+        while (in >> k >> value) {
+            if (k == key && value > 0) return value;
+        }
+        return std::nullopt;
+    }
+
+    static void store(const std::string& key, const int value) {
+        const auto path = cache_path();
+        std::vector<std::pair<std::string, int>> entries;
+        {
+            std::ifstream in(path);
+            std::string k;
+            int v = 0;
+            while (in >> k >> v) {
+                if (k != key) entries.emplace_back(k, v);
+            }
+        }
+        entries.emplace_back(key, value);
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+        std::ofstream out(path, std::ios::trunc);
+        for (const auto& [k, v] : entries) out << k << ' ' << v << '\n';
+    }
+};
+
+}  // namespace nbody
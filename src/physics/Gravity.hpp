@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <raylib-cpp.hpp>
+#include <vector>
+
+#include "../core/Math.hpp"
+#include "../core/Profiler.hpp"
+#include "SpatialPartition.hpp"
+
+namespace nbody {
+
+// World-independent gravity kernels over packed body arrays. Physics gathers the arrays from the ECS;
+// calibration and benchmarks feed them synthetic distributions. acc must be sized to positions.size()
+// and is accumulated into (callers zero it).
+class Gravity {
+public:
+    // O(N^2) pairwise summation using Newton's third law.
+    static void direct(const std::vector<DVec2>& positions, const std::vector<float>& masses,
+                       const std::vector<uint8_t>& pins, const double G, const double eps2, std::vector<DVec2>& acc) {
+        const size_t n = positions.size();
+        const DVec2* pos = positions.data();
+        const float* mass = masses.data();
+        const uint8_t* pin = pins.data();
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = i + 1; j < n; ++j) {
+                const double dx = pos[j].x - pos[i].x;
+                const double dy = pos[j].y - pos[i].y;
+                const double r2 = dx * dx + dy * dy + eps2;
+                const double invR = 1.0 / std::sqrt(r2);
+                const double invR3 = invR * invR * invR;
+
+                const double ax_i = G * static_cast<double>(mass[j]) * dx * invR3;
+                const double ay_i = G * static_cast<double>(mass[j]) * dy * invR3;
+                const double ax_j = -G * static_cast<double>(mass[i]) * dx * invR3;
+                const double ay_j = -G * static_cast<double>(mass[i]) * dy * invR3;
+
+                if (!pin[i]) {
+                    acc[i].x += ax_i;
+                    acc[i].y += ay_i;
+                }
+                if (!pin[j]) {
+                    acc[j].x += ax_j;
+                    acc[j].y += ay_j;
+                }
+            }
+        }
+    }
+
+    // Acceleration and its time derivative (jerk) in one pairwise pass, for the Hermite integrator:
+    //   a_i = G m_j r / |r|^3,  j_i = G m_j (v - 3 (r.v) r / |r|^2) / |r|^3,  r = x_j - x_i, v = v_j - v_i
+    // with |r|^2 softened by eps2 (the jerk is the exact derivative of the softened force). Body j gets the
+    // opposite terms scaled by m_i. acc and jerk are accumulated into.
+    static void direct_with_jerk(const std::vector<DVec2>& positions, const std::vector<DVec2>& velocities,
+                                 const std::vector<float>& masses, const std::vector<uint8_t>& pins, const double G,
+                                 const double eps2, std::vector<DVec2>& acc, std::vector<DVec2>& jerk) {
+        const size_t n = positions.size();
+        const DVec2* pos = positions.data();
+        const DVec2* vel = velocities.data();
+        const float* mass = masses.data();
+        const uint8_t* pin = pins.data();
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = i + 1; j < n; ++j) {
+                const double dx = pos[j].x - pos[i].x;
+                const double dy = pos[j].y - pos[i].y;
+                const double dvx = vel[j].x - vel[i].x;
+                const double dvy = vel[j].y - vel[i].y;
+                const double r2 = dx * dx + dy * dy + eps2;
+                const double invR = 1.0 / std::sqrt(r2);
+                const double invR2 = invR * invR;
+                const double invR3 = invR * invR2;
+                const double rv3 = 3.0 * (dx * dvx + dy * dvy) * invR2;
+
+                const double ax = dx * invR3;
+                const double ay = dy * invR3;
+                const double jx = (dvx - rv3 * dx) * invR3;
+                const double jy = (dvy - rv3 * dy) * invR3;
+
+                if (!pin[i]) {
+                    const double gm = G * static_cast<double>(mass[j]);
+                    acc[i].x += gm * ax;
+                    acc[i].y += gm * ay;
+                    jerk[i].x += gm * jx;
+                    jerk[i].y += gm * jy;
+                }
+                if (!pin[j]) {
+                    const double gm = G * static_cast<double>(mass[i]);
+                    acc[j].x -= gm * ax;
+                    acc[j].y -= gm * ay;
+                    jerk[j].x -= gm * jx;
+                    jerk[j].y -= gm * jy;
+                }
+            }
+        }
+    }
+
+    // O(N log N) Barnes-Hut approximation with opening angle theta. If cells is given, the tree is also
+    // exported there (leaf bodies refer to indices into positions). The body array and tree are per-thread
+    // scratch that keeps its capacity, so repeated calls do not allocate.
+    static void barnes_hut(const std::vector<DVec2>& positions, const std::vector<float>& masses,
+                           const std::vector<uint8_t>& pins, const double G, const double eps2, const double theta,
+                           std::vector<DVec2>& acc, std::vector<SpatialPartition::Cell>* cells = nullptr) {
+        const size_t n = positions.size();
+        static thread_local std::vector<SpatialPartition::Body> bodies;
+        static thread_local SpatialPartition tree;
+        {
+            Profiler::Scope timer(Profiler::Stage::GravityBuild);
+            bodies.clear();
+            bodies.reserve(n);
+            for (size_t i = 0; i < n; ++i)
+                bodies.push_back(
+                    {raylib::Vector2{static_cast<float>(positions[i].x), static_cast<float>(positions[i].y)},
+                     masses[i], static_cast<int>(i)});
+            tree.build(bodies);
+            if (cells) tree.export_cells(*cells);
+        }
+
+        Profiler::Scope timer(Profiler::Stage::GravityWalk);
+        for (size_t i = 0; i < n; ++i) {
+            if (pins[i]) continue;
+            raylib::Vector2 af{0.0f, 0.0f};
+            tree.compute_force(bodies[i], theta, G, eps2, af);
+            acc[i].x += static_cast<double>(af.x);
+            acc[i].y += static_cast<double>(af.y);
+        }
+    }
+};
+
+}  // namespace nbody
@@ -2,8 +2,7 @@
 
 #include <algorithm>
 #include <cmath>
-#include <memory>
-#include <array>
+#include <cstdint>
 #include <raylib-cpp.hpp>
 #include <vector>
 
@@ -17,23 +16,41 @@ public:
         int index;
     };
 
+    // Flattened node for consumers outside the gravity pass (e.g. the renderer). Children of an internal cell
+    // are the four consecutive cells starting at first_child; parents always precede their children.
+    struct Cell {
+        raylib::Vector2 center{};
+        float halfSize = 0.0F;
+        float mass = 0.0F;
+        raylib::Vector2 com{};
+        std::uint32_t first_child = 0;  // 0 = leaf (the root is never a child)
+        int body = -1;  // Body::index of a leaf's body, -1 if empty or internal
+    };
+
 private:
+    static constexpr std::uint32_t kEnd = ~std::uint32_t{0};
+
+    // Nodes live in one pool that keeps its capacity across builds, so steady-state rebuilds do not allocate.
+    // Like Cell, the children of an internal node are the four consecutive nodes from first_child and parents
+    // precede their children; next skips the node's subtree, which lets walks run without a stack.
     struct Node {
         raylib::Vector2 center{};
         float halfSize = 0.0F;
         float mass = 0.0F;
         raylib::Vector2 com{0.0F, 0.0F};
         Body* body = nullptr;
-        std::array<std::unique_ptr<Node>, 4> children{};
+        std::uint32_t first_child = 0;  // 0 = leaf (the root is never a child)
+        std::uint32_t next = kEnd;  // next node in depth-first order after this subtree
 
         Node(const raylib::Vector2& centerPos, float halfSizeVal) : center(centerPos), halfSize(halfSizeVal) {}
-        [[nodiscard]] auto is_leaf() const -> bool { return !children[0]; }
+        [[nodiscard]] auto is_leaf() const -> bool { return first_child == 0; }
     };
 
-    std::unique_ptr<Node> root;
+    std::vector<Node> nodes;
 
 public:
     void build(std::vector<Body>& bodies) {
+        nodes.clear();
         if (bodies.empty()) {
             return;
         }
@@ -53,169 +70,155 @@ public:
             size = 1.0F;
         }
         raylib::Vector2 center{(minX + maxX) * kHalf, (minY + maxY) * kHalf};
-        root = std::make_unique<Node>(center, size);
+        nodes.emplace_back(center, size);
         for (auto& body : bodies) {
-            insert_iterative(root.get(), &body);
+            insert_iterative(&body);
         }
-        aggregate_mass_com_iterative();
+        link_subtrees();
+        aggregate_mass_com();
     }
 
     void compute_force(const Body& target, double theta, double gravConst, double eps2, raylib::Vector2& acc) const {
-        if (!root) return;
-        // Explicit stack-based traversal to avoid recursion
-        std::vector<const Node*> stack;
-        stack.reserve(64);
-        stack.push_back(root.get());
-        while (!stack.empty()) {
-            const Node* node = stack.back();
-            stack.pop_back();
-            if (!node || node->mass <= 0.0F) continue;
-
-            if (node->is_leaf()) {
-                if (!node->body || node->body->index == target.index) continue;
-                const double dx = static_cast<double>(node->body->pos.x) - static_cast<double>(target.pos.x);
-                const double dy = static_cast<double>(node->body->pos.y) - static_cast<double>(target.pos.y);
+        if (nodes.empty()) return;
+        // Stackless depth-first walk: accept a node and skip its subtree, or open it
+        std::uint32_t i = 0;
+        while (i != kEnd) {
+            const Node& node = nodes[i];
+            if (node.mass <= 0.0F) {
+                i = node.next;
+                continue;
+            }
+
+            if (node.is_leaf()) {
+                i = node.next;
+                if (!node.body || node.body->index == target.index) continue;
+                const double dx = static_cast<double>(node.body->pos.x) - static_cast<double>(target.pos.x);
+                const double dy = static_cast<double>(node.body->pos.y) - static_cast<double>(target.pos.y);
                 const double r2 = (dx * dx) + (dy * dy) + eps2;
                 const double invR = 1.0 / std::sqrt(r2);
                 const double invR3 = invR * invR * invR;
-                const double ax = gravConst * static_cast<double>(node->body->mass) * dx * invR3;
-                const double ay = gravConst * static_cast<double>(node->body->mass) * dy * invR3;
+                const double ax = gravConst * static_cast<double>(node.body->mass) * dx * invR3;
+                const double ay = gravConst * static_cast<double>(node.body->mass) * dy * invR3;
                 acc.x += static_cast<float>(ax);
                 acc.y += static_cast<float>(ay);
                 continue;
             }
 
-            const double dx = static_cast<double>(node->com.x) - static_cast<double>(target.pos.x);
-            const double dy = static_cast<double>(node->com.y) - static_cast<double>(target.pos.y);
+            const double dx = static_cast<double>(node.com.x) - static_cast<double>(target.pos.x);
+            const double dy = static_cast<double>(node.com.y) - static_cast<double>(target.pos.y);
             const double dist = std::sqrt((dx * dx) + (dy * dy));
-            if ((static_cast<double>(node->halfSize) * 2.0) / dist < theta) {
+            if ((static_cast<double>(node.halfSize) * 2.0) / dist < theta) {
                 const double r2 = (dx * dx) + (dy * dy) + eps2;
                 const double invR = 1.0 / std::sqrt(r2);
                 const double invR3 = invR * invR * invR;
-                const double ax = gravConst * static_cast<double>(node->mass) * dx * invR3;
-                const double ay = gravConst * static_cast<double>(node->mass) * dy * invR3;
+                const double ax = gravConst * static_cast<double>(node.mass) * dx * invR3;
+                const double ay = gravConst * static_cast<double>(node.mass) * dy * invR3;
                 acc.x += static_cast<float>(ax);
                 acc.y += static_cast<float>(ay);
+                i = node.next;
             } else {
                 // Traverse children
-                for (const auto& child : node->children) {
-                    if (child) stack.push_back(child.get());
-                }
+                i = node.first_child;
             }
         }
     }
 
+    // The pool already has the Cell layout; out keeps its capacity between calls.
+    void export_cells(std::vector<Cell>& out) const {
+        out.resize(nodes.size());
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            const Node& node = nodes[i];
+            out[i] = Cell{node.center, node.halfSize, node.mass, node.com, node.first_child,
+                          node.body ? node.body->index : -1};
+        }
+    }
+
 private:
-    void insert_iterative(Node* node, Body* bodyPtr) {
-        // Insert a body into the tree without recursion. When a collision occurs
-        // (leaf already has a body), subdivide and reinsert the existing body,
-        // then continue inserting the new one.
+    void insert_iterative(Body* bodyPtr) {
+        // Insert a body into the tree without recursion. When the leaf reached already holds a body,
+        // subdivide it, move the existing body into its (empty) child and keep descending with the new one.
+        std::uint32_t node = 0;
         while (true) {
-            if (node->is_leaf()) {
-                if (node->body == nullptr) {
-                    node->body = bodyPtr;
-                    // mass/com aggregated later in a separate pass
-                    return;
-                }
-
-                // Subdivide and reinsert the existing body down the appropriate branch
-                Body* existing = node->body;
-                subdivide(node);
-                node->body = nullptr;
-
-                // Place the existing body first
-                Node* cur = node->children[static_cast<std::size_t>(get_quadrant(node, existing->pos))].get();
-                while (true) {
-                    if (cur->is_leaf()) {
-                        if (cur->body == nullptr) {
-                            cur->body = existing;
-                            break;
-                        } else {
-                            // Need to subdivide further
-                            Body* ex2 = cur->body;
-                            subdivide(cur);
-                            cur->body = nullptr;
-                            cur = cur->children[static_cast<std::size_t>(get_quadrant(cur, ex2->pos))].get();
-                            existing = ex2;
-                            continue;
-                        }
-                    } else {
-                        cur = cur->children[static_cast<std::size_t>(get_quadrant(cur, existing->pos))].get();
-                    }
-                }
-
-                // Now continue inserting the new body starting from current internal node
-                node = node->children[static_cast<std::size_t>(get_quadrant(node, bodyPtr->pos))].get();
+            if (!nodes[node].is_leaf()) {
+                node = child_for(node, bodyPtr->pos);
                 continue;
             }
-
-            // Not a leaf, descend towards the quadrant of the new body
-            const int quadrant = get_quadrant(node, bodyPtr->pos);
-            node = node->children[static_cast<std::size_t>(quadrant)].get();
+            if (nodes[node].body == nullptr) {
+                nodes[node].body = bodyPtr;
+                // mass/com aggregated later in a separate pass
+                return;
+            }
+            Body* existing = nodes[node].body;
+            nodes[node].body = nullptr;
+            subdivide(node);
+            nodes[child_for(node, existing->pos)].body = existing;
         }
     }
 
-    void subdivide(Node* node) {
+    void subdivide(const std::uint32_t node) {
         constexpr float kHalf = 0.5F;
-        const float hs = node->halfSize * kHalf;
-        const float cx = node->center.x;
-        const float cy = node->center.y;
-        node->children[0] = std::make_unique<Node>(raylib::Vector2{cx - hs, cy - hs}, hs);  // NW
-        node->children[1] = std::make_unique<Node>(raylib::Vector2{cx + hs, cy - hs}, hs);  // NE
-        node->children[2] = std::make_unique<Node>(raylib::Vector2{cx - hs, cy + hs}, hs);  // SW
-        node->children[3] = std::make_unique<Node>(raylib::Vector2{cx + hs, cy + hs}, hs);  // SE
+        // Copy first: emplace_back may reallocate the pool
+        const float hs = nodes[node].halfSize * kHalf;
+        const float cx = nodes[node].center.x;
+        const float cy = nodes[node].center.y;
+        const auto first = static_cast<std::uint32_t>(nodes.size());
+        nodes.emplace_back(raylib::Vector2{cx - hs, cy - hs}, hs);  // NW
+        nodes.emplace_back(raylib::Vector2{cx + hs, cy - hs}, hs);  // NE
+        nodes.emplace_back(raylib::Vector2{cx - hs, cy + hs}, hs);  // SW
+        nodes.emplace_back(raylib::Vector2{cx + hs, cy + hs}, hs);  // SE
+        nodes[node].first_child = first;
+    }
+
+    [[nodiscard]] auto child_for(const std::uint32_t node, const raylib::Vector2& point) const -> std::uint32_t {
+        return nodes[node].first_child + static_cast<std::uint32_t>(get_quadrant(nodes[node], point));
     }
 
-    static auto get_quadrant(const Node* node, const raylib::Vector2& point) -> int {
-        const bool east = point.x > node->center.x;
-        const bool south = point.y > node->center.y;
+    static auto get_quadrant(const Node& node, const raylib::Vector2& point) -> int {
+        const bool east = point.x > node.center.x;
+        const bool south = point.y > node.center.y;
         if (east) {
             return south ? 3 : 1;
         }
         return south ? 2 : 0;
     }
 
-    void aggregate_mass_com_iterative() {
-        if (!root) return;
-        // Post-order traversal using an explicit stack
-        struct Frame { Node* node; bool visited; };
-        std::vector<Frame> stack;
-        stack.reserve(128);
-        stack.push_back(Frame{root.get(), false});
-
-        while (!stack.empty()) {
-            Frame f = stack.back();
-            stack.pop_back();
-            Node* node = f.node;
-            if (!node) continue;
-
-            if (f.visited || node->is_leaf()) {
-                if (node->is_leaf()) {
-                    if (node->body) {
-                        node->mass = node->body->mass;
-                        node->com = node->body->pos;
-                    } else {
-                        node->mass = 0.0F;
-                        node->com = raylib::Vector2{0.0F, 0.0F};
-                    }
+    // Top-down (parents precede children): a child continues with its next sibling, the last one with whatever
+    // follows its parent.
+    void link_subtrees() {
+        nodes[0].next = kEnd;
+        for (const Node& node : nodes) {
+            if (node.is_leaf()) continue;
+            for (std::uint32_t q = 0; q < 4; ++q) {
+                nodes[node.first_child + q].next = q < 3 ? node.first_child + q + 1 : node.next;
+            }
+        }
+    }
+
+    // Bottom-up: children come after their parent, so a reverse sweep is a post-order traversal.
+    void aggregate_mass_com() {
+        for (std::size_t i = nodes.size(); i-- > 0;) {
+            Node& node = nodes[i];
+            if (node.is_leaf()) {
+                if (node.body) {
+                    node.mass = node.body->mass;
+                    node.com = node.body->pos;
                 } else {
-                    float mass_sum = 0.0F;
-                    raylib::Vector2 com_sum{0.0F, 0.0F};
-                    for (const auto& child : node->children) {
-                        if (child && child->mass > 0.0F) {
-                            mass_sum += child->mass;
-                            com_sum += child->com * child->mass;
-                        }
-                    }
-                    node->mass = mass_sum;
-                    node->com = (mass_sum > 0.0F) ? (com_sum * (1.0F / mass_sum)) : raylib::Vector2{0.0F, 0.0F};
+                    node.mass = 0.0F;
+                    node.com = raylib::Vector2{0.0F, 0.0F};
                 }
-            } else {
-                stack.push_back(Frame{node, true});
-                for (auto& child : node->children) {
-                    if (child) stack.push_back(Frame{child.get(), false});
+                continue;
+            }
+            float mass_sum = 0.0F;
+            raylib::Vector2 com_sum{0.0F, 0.0F};
+            for (std::uint32_t q = 0; q < 4; ++q) {
+                const Node& child = nodes[node.first_child + q];
+                if (child.mass > 0.0F) {
+                    mass_sum += child.mass;
+                    com_sum += child.com * child.mass;
                 }
             }
+            node.mass = mass_sum;
+            node.com = (mass_sum > 0.0F) ? (com_sum * (1.0F / mass_sum)) : raylib::Vector2{0.0F, 0.0F};
         }
     }
 };
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <raylib.h>
+
+#include "../core/AllocationCounter.hpp"
+#include "../core/Constants.hpp"
+#include "../core/Profiler.hpp"
+
+namespace nbody {
+
+// Zero-allocation test mode (--alloc-check): fails the run when steady-state frames allocate.
+// - Turns on AllocationCounter, lets a warm-up period pass (scratch buffers grow to size, startup calibration runs),
+//   then inspects the Profiler record of each of the next `frames` frames.
+// - Any heap allocation inside a profiled stage (physics, rendering, UI) is a failure and is logged with its frame
+//   and stage. Allocations outside the stages (raylib, the GL driver, the trace writer) are totalled in the summary
+//   but do not fail the check.
+// Main thread only; update() runs after Profiler::end_frame().
+class AllocationCheck {
+public:
+    enum class State : std::uint8_t { Off, WarmUp, Checking, Passed, Failed };
+
+    static void start(const int frames, const int warmUp = constants::alloc_check_warmup_frames) {
+        AllocationCounter::set_enabled(true);
+        s_frames = frames;
+        s_warmup_left = warmUp;
+        s_checked = 0;
+        s_failed_frames = 0;
+        s_stage_allocations = 0;
+        s_other_allocations = 0;
+        s_state = State::WarmUp;
+        TraceLog(LOG_INFO, "alloc-check: warming up for %d frames, then checking %d", warmUp, frames);
+    }
+
+    static void update() {
+        if (s_state == State::WarmUp) {
+            if (--s_warmup_left <= 0) s_state = State::Checking;
+            return;
+        }
+        if (s_state != State::Checking || Profiler::frame_count() == 0) return;
+
+        const Profiler::Frame& f = Profiler::frame(0);
+        std::uint64_t inStages = 0;
+        for (std::size_t s = 0; s < Profiler::kStages; ++s) {
+            if (f.stage_allocs[s] == 0) continue;
+            inStages += f.stage_allocs[s];
+            if (s_failed_frames < constants::alloc_check_max_reports) {
+                TraceLog(LOG_WARNING, "alloc-check: frame %d: %s made %u allocations (%llu bytes)", s_checked,
+                         Profiler::label(static_cast<Profiler::Stage>(s)), f.stage_allocs[s],
+                         static_cast<unsigned long long>(f.stage_bytes[s]));
+            }
+        }
+        if (inStages > 0) ++s_failed_frames;
+        s_stage_allocations += inStages;
+        s_other_allocations += f.frame_allocs > inStages ? f.frame_allocs - inStages : 0;
+        ++s_checked;
+        if (s_checked < s_frames) return;
+
+        s_state = s_failed_frames == 0 ? State::Passed : State::Failed;
+        TraceLog(s_state == State::Passed ? LOG_INFO : LOG_ERROR,
+                 "alloc-check: %s: %d of %d frames allocated in profiled stages (%llu allocations); "
+                 "%llu allocations outside stages",
+                 s_state == State::Passed ? "PASSED" : "FAILED", s_failed_frames, s_checked,
+                 static_cast<unsigned long long>(s_stage_allocations),
+                 static_cast<unsigned long long>(s_other_allocations));
+    }
+
+    [[nodiscard]] static auto state() -> State { return s_state; }
+    [[nodiscard]] static auto finished() -> bool { return s_state == State::Passed || s_state == State::Failed; }
+    [[nodiscard]] static auto failed() -> bool { return s_state == State::Failed; }
+
+private:
+    static inline State s_state = State::Off;
+    static inline int s_frames = 0;
+    static inline int s_warmup_left = 0;
+    static inline int s_checked = 0;
+    static inline int s_failed_frames = 0;
+    static inline std::uint64_t s_stage_allocations = 0;
+    static inline std::uint64_t s_other_allocations = 0;
+};
+
+}  // namespace nbody
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <flecs.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../core/Checkpoint.hpp"
+#include "../core/Config.hpp"
+#include "../core/ScenarioFile.hpp"
+#include "Governor.hpp"
+#include "Physics.hpp"
+
+namespace nbody {
+
+// Periodic crash-safe checkpoints of the running simulation.
+// - When a checkpoint is due, the simulation thread copies the world into a reusable Checkpoint::Image (one pass
+//   over the component columns, no allocation once the buffers have grown) and returns to stepping.
+// - A background thread writes the image to a temporary file, syncs it and renames it over latest_path().
+// - If the previous write is still in flight, the due checkpoint is deferred to the next step instead of waiting.
+class Checkpointer {
+public:
+    struct Stats {
+        std::atomic<std::uint64_t> written{0};
+        std::atomic<std::uint64_t> failed{0};
+        std::atomic<std::uint64_t> last_step{0};  // step of the newest checkpoint on disk
+        std::atomic<double> last_write_ms{0.0};
+    };
+
+    static std::filesystem::path checkpoint_dir() {
+        return ScenarioFile::scenario_dir().parent_path() / "checkpoints";
+    }
+    static std::filesystem::path latest_path() {
+        return checkpoint_dir() / (std::string("latest") + Checkpoint::kExtension);
+    }
+
+    // Called by the simulation after every step.
+    static void capture(const flecs::world& w, const std::uint64_t step, const double simTime) {
+        const auto* cfg = w.get<Config>();
+        if (!cfg) return;
+        const auto now = Clock::now();
+        const bool due = s_request_now.exchange(false) ||
+            (cfg->checkpoint_enabled &&
+             now - s_last_capture >= std::chrono::duration<double>(std::max(1.0F, cfg->checkpoint_interval_s)));
+        if (!due) return;
+        Worker& worker = Worker::instance();
+        if (worker.busy.load(std::memory_order_acquire)) {
+            s_request_now.store(true);  // retry after the next step
+            return;
+        }
+        s_last_capture = now;
+        Checkpoint::Image& img = worker.image;
+        Checkpoint::capture(w, img);
+        img.hermite_forces = Physics::export_hermite(w, img.ids, img.accelerations, img.jerks);
+        img.step = step;
+        img.sim_time = simTime;
+        if (const auto* gov = w.get<Governor::State>()) {
+            img.governor_ema_ms = gov->ema_ms;
+            img.governor_cooldown = gov->cooldown;
+            img.governor_adjustments = gov->adjustments;
+        }
+        worker.post();
+    }
+
+    // Write a checkpoint after the next step, regardless of the interval.
+    static void request() { s_request_now.store(true); }
+
+    // Load a checkpoint into the world (bodies, Config, governor state, Hermite forces). On success step/simTime
+    // hold the simulation clock to resume from.
+    static bool restore(const flecs::world& w, const std::filesystem::path& path, std::uint64_t& step,
+                        double& simTime) {
+        Checkpoint::Image img;
+        if (!Checkpoint::load(path, img)) return false;
+        std::vector<flecs::entity_t> created;
+        Checkpoint::restore(w, img, &created);
+        if (img.hermite_forces) seed_hermite(w, img, std::move(created));
+        if (auto* gov = w.get_mut<Governor::State>()) {
+            gov->ema_ms = img.governor_ema_ms;
+            gov->cooldown = img.governor_cooldown;
+            gov->adjustments = img.governor_adjustments;
+        }
+        step = img.step;
+        simTime = img.sim_time;
+        s_last_capture = Clock::now();
+        return true;
+    }
+
+    [[nodiscard]] static auto stats() -> const Stats& { return Worker::instance().stats; }
+    [[nodiscard]] static auto writing() -> bool { return Worker::instance().busy.load(std::memory_order_acquire); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static inline Clock::time_point s_last_capture = Clock::now();  // simulation thread only
+    static inline std::atomic<bool> s_request_now{false};
+
+    // Hand the checkpointed Hermite forces to the first step; created holds the restored entities in image order.
+    static void seed_hermite(const flecs::world& w, const Checkpoint::Image& img,
+                             std::vector<flecs::entity_t> created) {
+        const std::size_t n = img.size();
+        Physics::HermiteSeed seed;
+        seed.ids = std::move(created);
+        seed.x.resize(n);
+        seed.v.resize(n);
+        seed.a.resize(n);
+        seed.masses.resize(n);
+        seed.pins.resize(n);
+        for (std::size_t k = 0; k < n; ++k) {
+            seed.x[k] = img.positions[k].value;
+            seed.v[k] = img.velocities[k].value;
+            seed.a[k] = img.accelerations[k].value;
+            seed.masses[k] = img.masses[k].value;
+            seed.pins[k] = img.pinned[k].value ? 1 : 0;
+        }
+        seed.jerk = img.jerks;
+        seed.G = img.config.g;
+        seed.eps2 = static_cast<double>(img.config.softening) * static_cast<double>(img.config.softening);
+        w.set<Physics::HermiteSeed>(std::move(seed));
+    }
+
+    // One image and one writer thread; busy is set from capture until the file is renamed into place.
+    struct Worker {
+        Checkpoint::Image image;
+        Stats stats;
+        std::atomic<bool> busy{false};
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool pending = false;
+        bool stopping = false;
+        std::thread thread;  // last: started after the members above exist
+
+        static auto instance() -> Worker& {
+            static Worker worker;
+            return worker;
+        }
+
+        Worker() : thread([this] { run(); }) {}
+        ~Worker() {
+            {
+                std::scoped_lock lock(mutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            thread.join();
+        }
+        Worker(const Worker&) = delete;
+        Worker& operator=(const Worker&) = delete;
+
+        void post() {
+            busy.store(true, std::memory_order_release);
+            {
+                std::scoped_lock lock(mutex);
+                pending = true;
+            }
+            wake.notify_one();
+        }
+
+        void run() {
+            std::unique_lock lock(mutex);
+            while (true) {
+                wake.wait(lock, [this] { return stopping || pending; });
+                if (pending) {
+                    pending = false;
+                    lock.unlock();
+                    const auto start = Clock::now();
+                    if (Checkpoint::save(latest_path(), image)) {
+                        stats.written.fetch_add(1);
+                        stats.last_step.store(image.step);
+                    } else {
+                        stats.failed.fetch_add(1);
+                    }
+                    stats.last_write_ms.store(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+                    busy.store(false, std::memory_order_release);
+                    lock.lock();
+                }
+                if (stopping) return;  // a posted image is written before shutdown
+            }
+        }
+    };
+};
+
+}  // namespace nbody
@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <flecs.h>
 #include <numbers>
+#include <vector>
 
 #include "../components/Components.hpp"
 #include "../core/Constants.hpp"
@@ -57,8 +58,10 @@ struct Collision {
             bool pinned;
         };
 
-        std::vector<BodyRef> bodies;
-        bodies.reserve(512);
+        // Reused between steps so steady-state resolves do not allocate
+        static thread_local std::vector<BodyRef> bodies;
+        static thread_local std::vector<uint8_t> alive;
+        bodies.clear();
         w.each([&](const flecs::entity e, const Position& p, const Velocity& v, const Mass& m, const Pinned& pin) {
             if (!(std::isfinite(p.value.x) && std::isfinite(p.value.y) && std::isfinite(static_cast<double>(m.value))))
                 return;
@@ -69,7 +72,7 @@ struct Collision {
         const size_t n = bodies.size();
         if (n < 2) return;
 
-        std::vector<uint8_t> alive(n, 1);
+        alive.assign(n, 1);
 
         // Pairwise detection and resolution
         for (size_t i = 0; i < n; ++i) {
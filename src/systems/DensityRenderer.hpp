@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <raylib-cpp.hpp>
+#include <vector>
+
+#include "../core/Config.hpp"
+#include "../core/Constants.hpp"
+#include "../core/Parallel.hpp"
+#include "../core/RenderSnapshot.hpp"
+
+namespace nbody::systems {
+
+// Density view for very large N: instead of drawing bodies, accumulate mass (or count) per screen cell on the
+// CPU, tone-map it with log scaling and show it as one texture. Cost is O(N) splats plus O(pixels), with both
+// passes split across hardware threads, so frame time stays flat no matter how many bodies overlap.
+class DensityRenderer {
+public:
+    // Render mode in Config::render_mode: 0 = auto, 1 = always bodies, 2 = always density.
+    [[nodiscard]] static auto active(const RenderSnapshot& snap) -> bool {
+        const Config& cfg = snap.cfg;
+        if (cfg.render_mode == 2) return true;
+        if (cfg.render_mode == 1) return false;
+        return static_cast<int>(snap.size()) >= cfg.density_auto_bodies;
+    }
+
+    // Draws in screen space; call outside BeginMode2D.
+    static void draw(const RenderSnapshot& snap, const double alpha, const raylib::Camera2D& cam) {
+        const Config& cfg = snap.cfg;
+        const int cell = std::max(1, cfg.density_downsample);
+        const int w = std::max(1, GetScreenWidth() / cell);
+        const int h = std::max(1, GetScreenHeight() / cell);
+        if (!ensure_texture(w, h)) return;
+        const auto cells = static_cast<std::size_t>(w) * static_cast<std::size_t>(h);
+
+        // World -> cell transform matching Camera2D: offset + zoom * R(rotation) * (p - target).
+        const double rot = static_cast<double>(cam.rotation) * DEG2RAD;
+        const double scale = static_cast<double>(cam.zoom) / cell;
+        const double cr = std::cos(rot) * scale;
+        const double sr = std::sin(rot) * scale;
+        const double tx = cam.target.x;
+        const double ty = cam.target.y;
+        const double ox = static_cast<double>(cam.offset.x) / cell;
+        const double oy = static_cast<double>(cam.offset.y) / cell;
+
+        // Pass 1: each chunk of bodies splats into its own buffer (no atomics, no sharing).
+        const std::size_t n = snap.size();
+        const auto width = static_cast<std::size_t>(w);
+        const std::size_t chunks = Parallel::chunk_count(n, constants::density_min_bodies_per_chunk);
+        if (s_accum.size() < chunks) s_accum.resize(chunks);
+        Parallel::for_chunks(n, constants::density_min_bodies_per_chunk, [&](const std::size_t c,
+                                                                           const std::size_t begin,
+                                                                           const std::size_t end) {
+            std::vector<float>& buf = s_accum[c];
+            buf.assign(cells, 0.0F);
+            for (std::size_t i = begin; i < end; ++i) {
+                const DVec2 p = snap.position_at(i, alpha);
+                const double dx = p.x - tx;
+                const double dy = p.y - ty;
+                const double sx = ox + cr * dx - sr * dy;
+                const double sy = oy + sr * dx + cr * dy;
+                // Negated in-range test so NaN / infinite positions (never in range) are skipped before the cast.
+                if (!(sx >= 0.0 && sx < w && sy >= 0.0 && sy < h)) continue;
+                const auto at = static_cast<std::size_t>(sy) * width + static_cast<std::size_t>(sx);
+                buf[at] += cfg.density_by_mass ? snap.masses[i] : 1.0F;
+            }
+        });
+
+        // Pass 2: reduce the chunk buffers into the first one, tracking the peak per row band.
+        const auto rows = static_cast<std::size_t>(h);
+        const std::size_t bands = Parallel::chunk_count(rows, constants::density_min_rows_per_chunk);
+        s_band_max.assign(bands, 0.0F);
+        Parallel::for_chunks(rows, constants::density_min_rows_per_chunk, [&](const std::size_t band,
+                                                                              const std::size_t r0,
+                                                                              const std::size_t r1) {
+            float peak = 0.0F;
+            float* out = s_accum[0].data();
+            for (std::size_t k = r0 * width; k < r1 * width; ++k) {
+                float sum = out[k];
+                for (std::size_t c = 1; c < chunks; ++c) sum += s_accum[c][k];
+                out[k] = sum;
+                peak = std::max(peak, sum);
+            }
+            s_band_max[band] = peak;
+        });
+        const float peak = *std::max_element(s_band_max.begin(), s_band_max.end());
+
+        // Pass 3: log tone-map relative to the frame's peak; exposure lifts faint regions.
+        s_pixels.resize(cells);
+        const float exposure = std::max(1.0F, cfg.density_exposure);
+        const float invPeak = peak > 0.0F ? exposure / peak : 0.0F;
+        const float invLog = 1.0F / std::log1p(exposure);
+        Parallel::for_chunks(rows, constants::density_min_rows_per_chunk, [&](std::size_t, const std::size_t r0,
+                                                                              const std::size_t r1) {
+            const float* in = s_accum[0].data();
+            for (std::size_t k = r0 * width; k < r1 * width; ++k) {
+                s_pixels[k] = in[k] > 0.0F ? ramp(std::log1p(in[k] * invPeak) * invLog) : Color{0, 0, 0, 0};
+            }
+        });
+
+        UpdateTexture(s_tex, s_pixels.data());
+        const Rectangle src{0.0F, 0.0F, static_cast<float>(w), static_cast<float>(h)};
+        const Rectangle dst{0.0F, 0.0F, static_cast<float>(w * cell), static_cast<float>(h * cell)};
+        DrawTexturePro(s_tex, src, dst, ::Vector2{0.0F, 0.0F}, 0.0F, WHITE);
+    }
+
+    // Release GPU resources; call before CloseWindow().
+    static void shutdown() {
+        if (s_tex.id != 0) UnloadTexture(s_tex);
+        s_tex = Texture2D{};
+    }
+
+private:
+    static inline Texture2D s_tex{};
+    static inline std::vector<std::vector<float>> s_accum;  // one buffer per body chunk; [0] holds the total
+    static inline std::vector<float> s_band_max;
+    static inline std::vector<Color> s_pixels;
+
+    static bool ensure_texture(const int w, const int h) {
+        if (s_tex.id != 0 && s_tex.width == w && s_tex.height == h) return true;
+        shutdown();
+        Image img = GenImageColor(w, h, BLANK);
+        s_tex = LoadTextureFromImage(img);
+        UnloadImage(img);
+        if (s_tex.id == 0) return false;
+        SetTextureFilter(s_tex, TEXTURE_FILTER_POINT);
+        return true;
+    }
+
+    // Dark blue -> orange -> near white over v in [0, 1].
+    static Color ramp(const float v) {
+        const auto mix = [](const Color a, const Color b, const float t) {
+            const auto ch = [t](const unsigned char x, const unsigned char y) {
+                const auto from = static_cast<float>(x);
+                return static_cast<unsigned char>(from + (static_cast<float>(y) - from) * t);
+            };
+            return Color{ch(a.r, b.r), ch(a.g, b.g), ch(a.b, b.b), 255};
+        };
+        const float t = std::clamp(v, 0.0F, 1.0F);
+        return (t < 0.5F) ? mix(constants::density_low, constants::density_mid, 2.0F * t)
+                          : mix(constants::density_mid, constants::density_high, 2.0F * t - 1.0F);
+    }
+};
+
+}  // namespace nbody::systems
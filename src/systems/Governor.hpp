@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <flecs.h>
+
+#include "../components/Components.hpp"
+#include "../core/Config.hpp"
+#include "../core/Constants.hpp"
+
+namespace nbody {
+
+// Frame budget governor: holds the simulation step time near Config::governor_target_ms by trading accuracy
+// for speed, always within the user-set bounds.
+// - Over budget, it degrades in order of least visible impact: diagnostics cadence, then Barnes-Hut theta
+//   (only while BH is active), then the substep cap.
+// - Well under budget, it restores in reverse order.
+// One knob moves per adjustment, followed by a cooldown so the moving average can settle.
+class Governor {
+public:
+    struct State {
+        double ema_ms = 0.0;  // smoothed step time
+        int cooldown = 0;
+        int adjustments = 0;
+        const char* last_action = "none";
+    };
+
+    static void register_systems(const flecs::world& w) { w.set<State>({}); }
+
+    // Called by the simulation after every step with that step's wall time.
+    static void update(const flecs::world& w, const double stepMs) {
+        auto* cfg = w.get_mut<Config>();
+        auto* st = w.get_mut<State>();
+        if (!cfg || !st) return;
+        st->ema_ms = (st->ema_ms <= 0.0)
+            ? stepMs
+            : st->ema_ms + constants::governor_ema_weight * (stepMs - st->ema_ms);
+        if (!cfg->governor_enabled) return;
+
+        clamp_to_bounds(*cfg);
+        if (st->cooldown > 0) {
+            --st->cooldown;
+            return;
+        }
+
+        const double target = static_cast<double>(cfg->governor_target_ms);
+        const bool bhActive = w.count<Position>() > cfg->bh_threshold;
+        const char* action = nullptr;
+        if (st->ema_ms > target * constants::governor_over_ratio) {
+            action = degrade(*cfg, bhActive);
+        } else if (st->ema_ms < target * constants::governor_under_ratio) {
+            action = restore(*cfg, bhActive);
+        }
+        if (action) {
+            st->last_action = action;
+            ++st->adjustments;
+            st->cooldown = constants::governor_cooldown_steps;
+        }
+    }
+
+private:
+    static void clamp_to_bounds(Config& cfg) {
+        cfg.governor_theta_max = std::max(cfg.governor_theta_min, cfg.governor_theta_max);
+        cfg.governor_substeps_max = std::max(cfg.governor_substeps_min, cfg.governor_substeps_max);
+        cfg.governor_diag_interval_max = std::max(1, cfg.governor_diag_interval_max);
+        cfg.bh_theta = std::clamp(cfg.bh_theta, cfg.governor_theta_min, cfg.governor_theta_max);
+        cfg.max_substeps_per_frame =
+            std::clamp(cfg.max_substeps_per_frame, cfg.governor_substeps_min, cfg.governor_substeps_max);
+        cfg.diagnostics_interval = std::clamp(cfg.diagnostics_interval, 1, cfg.governor_diag_interval_max);
+    }
+
+    static const char* degrade(Config& cfg, const bool bhActive) {
+        if (cfg.diagnostics_interval < cfg.governor_diag_interval_max) {
+            cfg.diagnostics_interval = std::min(cfg.diagnostics_interval * 2, cfg.governor_diag_interval_max);
+            return "diagnostics less often";
+        }
+        if (bhActive && cfg.bh_theta < cfg.governor_theta_max) {
+            cfg.bh_theta = std::min(cfg.bh_theta * constants::governor_theta_factor, cfg.governor_theta_max);
+            return "raised BH theta";
+        }
+        if (cfg.max_substeps_per_frame > cfg.governor_substeps_min) {
+            cfg.max_substeps_per_frame = std::max(cfg.max_substeps_per_frame / 2, cfg.governor_substeps_min);
+            return "lowered substep cap";
+        }
+        return nullptr;
+    }
+
+    static const char* restore(Config& cfg, const bool bhActive) {
+        if (cfg.max_substeps_per_frame < cfg.governor_substeps_max) {
+            cfg.max_substeps_per_frame = std::min(cfg.max_substeps_per_frame * 2, cfg.governor_substeps_max);
+            return "raised substep cap";
+        }
+        if (bhActive && cfg.bh_theta > cfg.governor_theta_min) {
+            cfg.bh_theta = std::max(cfg.bh_theta / constants::governor_theta_factor, cfg.governor_theta_min);
+            return "lowered BH theta";
+        }
+        if (cfg.diagnostics_interval > 1) {
+            cfg.diagnostics_interval = std::max(cfg.diagnostics_interval / 2, 1);
+            return "diagnostics more often";
+        }
+        return nullptr;
+    }
+};
+
+}  // namespace nbody
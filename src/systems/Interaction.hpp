@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
 #include <flecs.h>
 #include <imgui.h>
@@ -11,7 +12,9 @@
 #include "../core/Config.hpp"
 #include "../core/Colors.hpp"
 #include "../core/Constants.hpp"
+#include "../core/RenderSnapshot.hpp"
 #include "Camera.hpp"
+#include "Simulation.hpp"
 
 namespace nbody {
 
@@ -32,8 +35,10 @@ public:
 
     static void register_systems(const flecs::world& world) { world.set<State>({}); }
 
+    // The selection only counts while its entity still carries Selected: assign_bodies() strips the tag when it
+    // reuses the entity for another body.
     static flecs::entity get_selected(const flecs::world& world) {
-        if (const auto* s = world.get<State>()) return s->selected_entity;
+        if (const auto* s = world.get<State>(); s && selection_valid(s->selected_entity)) return s->selected_entity;
         return flecs::entity::null();
     }
 
@@ -54,8 +59,18 @@ public:
         auto* state = world.get_mut<State>();
         if (!state) return;
 
-        // Always end velocity drag on right-button release, even if UI captures mouse
-        if (IsMouseButtonReleased(MOUSE_BUTTON_RIGHT)) end_velocity_drag(world);
+        // Bodies were replaced under the selection (scenario load, import, generate): forget it and any drag on it.
+        if (state->selected_entity != flecs::entity::null() && !selection_valid(state->selected_entity)) {
+            state->selected_entity = flecs::entity::null();
+            state->is_dragging_selected = false;
+            state->is_dragging_velocity = false;
+        }
+
+        // Always end velocity drag on right-button release, even if UI captures mouse.
+        // Defensive: also end it if the button is no longer held, so the preview line disappears.
+        if (IsMouseButtonReleased(MOUSE_BUTTON_RIGHT) ||
+            (state->is_dragging_velocity && !IsMouseButtonDown(MOUSE_BUTTON_RIGHT)))
+            end_velocity_drag(world);
 
         const ImGuiIO& io = ImGui::GetIO();
         const bool ui_blocks_mouse =
@@ -71,17 +86,23 @@ public:
             const auto* cfg = world.get<Config>();
             const bool shiftDown = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
             if (cfg && cfg->enable_shift_click_add && shiftDown) {
-                world.entity()
-                    .set<Position>({mouseWorld})
-                    .set<Velocity>({dvec2(cfg->add_spawn_velocity)})
-                    .set<Acceleration>({DVec2{0.0, 0.0}})
-                    .set<PrevAcceleration>({DVec2{0.0, 0.0}})
-                    .set<Mass>({std::max(nbody::constants::spawn_mass_min, cfg->add_spawn_mass)})
-                    .set<Pinned>({cfg->add_spawn_pinned})
-                    .set<Tint>({random_nice_color()})
-                    .set<Trail>({{}})
-                    .add<Selectable>()
-                    .set<Draggable>({true, cfg->add_drag_vel_scale});
+                Simulation::submit(world, [mouseWorld, vel = dvec2(cfg->add_spawn_velocity),
+                                           mass = std::max(nbody::constants::spawn_mass_min, cfg->add_spawn_mass),
+                                           pinned = cfg->add_spawn_pinned, tint = random_nice_color(),
+                                           dragScale = cfg->add_drag_vel_scale](const flecs::world& w) {
+                    w.entity()
+                        .set<Position>({mouseWorld})
+                        .set<PrevPosition>({mouseWorld})
+                        .set<Velocity>({vel})
+                        .set<Acceleration>({DVec2{0.0, 0.0}})
+                        .set<PrevAcceleration>({DVec2{0.0, 0.0}})
+                        .set<Mass>({mass})
+                        .set<Pinned>({pinned})
+                        .set<Tint>({tint})
+                        .set<Trail>({})
+                        .add<Selectable>()
+                        .set<Draggable>({true, dragScale});
+                });
                 // Do not process this click further (avoid panning/selection)
                 return;
             }
@@ -98,50 +119,38 @@ public:
         state->hovered_entity = find_entity_at_position(world, mouseWorld, pickRadius);
     }
 
-    static void render_overlay(const flecs::world& world, const raylib::Camera2D& camera) {
-        const auto* state = world.get<State>();
-        if (!state) return;
-        // Defensive: if drag state somehow persisted but the right button is no longer held,
-        // end the drag so the preview line disappears.
-        if (state->is_dragging_velocity && !IsMouseButtonDown(MOUSE_BUTTON_RIGHT)) {
-            end_velocity_drag(world);
-        }
+    // Draws from the published snapshot and a copy of the interaction state, so it never touches the world.
+    static void render_overlay(const RenderSnapshot& snap, const double alpha, const State& state,
+                               const raylib::Camera2D& camera) {
         BeginMode2D(camera);
-        if (state->is_dragging_velocity) {
-            const raylib::Vector2 a = fvec2(state->drag_start_world);
-            const raylib::Vector2 b = fvec2(state->current_drag_world);
+        if (state.is_dragging_velocity) {
+            const raylib::Vector2 a = fvec2(state.drag_start_world);
+            const raylib::Vector2 b = fvec2(state.current_drag_world);
             DrawLineEx(a, b, nbody::constants::drag_line_width / camera.zoom, WHITE);
             DrawCircleV(a, nbody::constants::drag_circle_radius / camera.zoom, WHITE);
             DrawCircleV(b, nbody::constants::drag_circle_radius / camera.zoom, WHITE);
         }
-        if (state->selected_entity.is_alive()) {
-            const auto* pos = state->selected_entity.get<Position>();
-            const auto* mass = state->selected_entity.get<Mass>();
-            const auto* rad = state->selected_entity.get<Radius>();
-            if (pos && mass) {
-                double rMeters = rad ? rad->value : 0.0;
-                if (!rad) {
-                    const double safeMass = std::max(1.0, static_cast<double>(mass->value));
-                    rMeters = std::cbrt((3.0 * safeMass) / (4.0 * std::numbers::pi * nbody::constants::body_density));
-                }
-                const auto* cfg = world.get<Config>();
-                const float minRadiusWorld = nbody::constants::min_body_radius / camera.zoom;
-                const float bodyRadius = std::max(minRadiusWorld,
-                                                  (cfg ? cfg->radius_scale : nbody::constants::default_radius_scale) *
-                                                      static_cast<float>(rMeters));
-                const float ringRadius = bodyRadius + nbody::constants::ring_extra_radius / camera.zoom;
-                DrawRing(fvec2(pos->value), ringRadius, ringRadius + nbody::constants::ring_thickness / camera.zoom,
-                         nbody::constants::ring_start_angle, nbody::constants::ring_end_angle,
-                         nbody::constants::ring_segments, YELLOW);
-                DrawCircleLines(static_cast<int>(pos->value.x), static_cast<int>(pos->value.y),
-                                bodyRadius + nbody::constants::ring_inner_offset / camera.zoom,
-                                ColorAlpha(WHITE, nbody::constants::selected_circle_alpha));
-            }
+        const flecs::entity_t selectedId = state.selected_entity.id();
+        const auto it = std::find(snap.ids.begin(), snap.ids.end(), selectedId);
+        if (selectedId != 0 && it != snap.ids.end()) {
+            const auto i = static_cast<size_t>(it - snap.ids.begin());
+            const raylib::Vector2 pos = fvec2(snap.position_at(i, alpha));
+            const float minRadiusWorld = nbody::constants::min_body_radius / camera.zoom;
+            const float bodyRadius = std::max(minRadiusWorld, snap.cfg.radius_scale * snap.radii[i]);
+            const float ringRadius = bodyRadius + nbody::constants::ring_extra_radius / camera.zoom;
+            DrawRing(pos, ringRadius, ringRadius + nbody::constants::ring_thickness / camera.zoom,
+                     nbody::constants::ring_start_angle, nbody::constants::ring_end_angle,
+                     nbody::constants::ring_segments, YELLOW);
+            DrawCircleLines(static_cast<int>(pos.x), static_cast<int>(pos.y),
+                            bodyRadius + nbody::constants::ring_inner_offset / camera.zoom,
+                            ColorAlpha(WHITE, nbody::constants::selected_circle_alpha));
         }
         EndMode2D();
     }
 
 private:
+    static bool selection_valid(const flecs::entity e) { return e.is_alive() && e.has<Selected>(); }
+
     static flecs::entity find_entity_at_position(const flecs::world& world, const DVec2& worldPos,
                                                  float pickRadius) {
         flecs::entity best = flecs::entity::null();
@@ -7,12 +7,15 @@
 #include <raylib-cpp.hpp>
 #include <raymath.h>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "../components/Components.hpp"
 #include "../core/Config.hpp"
 #include "../core/Constants.hpp"
-#include "../physics/SpatialPartition.hpp"
+#include "../core/Profiler.hpp"
+#include "../core/TrailPool.hpp"
+#include "../physics/Gravity.hpp"
 #include "Collision.hpp"
 
 namespace nbody {
@@ -29,12 +32,29 @@ public:
         bool ok = true;
     };
 
+    // Last Barnes-Hut tree, kept for the renderer's zoomed-out aggregation (empty when direct summation ran).
+    // Leaf Cell::body indexes entities.
+    struct GravityTree {
+        std::vector<SpatialPartition::Cell> cells;
+        std::vector<flecs::entity_t> entities;
+    };
+
     static void register_systems(const flecs::world& w) {
+        w.set<TrailPool>({});
+        w.set<GravityTree>({});
+
         // Collisions: resolve overlaps before computing forces.
         w.system<>().kind(flecs::OnUpdate).iter([&](flecs::iter&) {
             auto* cfg = w.get<Config>();
             if (!cfg || cfg->paused) return;
-            nbody::systems::Collision::resolve(w);
+            {
+                Profiler::Scope timer(Profiler::Stage::Collision);
+                nbody::systems::Collision::resolve(w);
+            }
+            // Diagnostics are O(N^2); honour the configured cadence (the governor may stretch it)
+            if (++s_steps_since_diagnostics < std::max(1, cfg->diagnostics_interval)) return;
+            s_steps_since_diagnostics = 0;
+            Profiler::Scope timer(Profiler::Stage::Diagnostics);
             Diagnostics d{};
             d.ok = compute_diagnostics(w, cfg->g,
                                        static_cast<double>(cfg->softening) * static_cast<double>(cfg->softening), d);
@@ -43,7 +63,7 @@ public:
 
         // Gravity: once per frame before integration.
         w.system<>().kind(flecs::OnUpdate).iter([&](flecs::iter&) {
-            if (const Config& cfg = *w.get<Config>(); cfg.paused) return;
+            if (const Config& cfg = *w.get<Config>(); cfg.paused || !needs_gravity_pass(cfg)) return;
             compute_gravity(w);
         });
 
@@ -53,12 +73,14 @@ public:
             if (cfg.paused) return;
             const float baseDt = cfg.use_fixed_dt ? cfg.fixed_dt : (float)it.delta_time();
             const float dtEff = baseDt * std::max(0.0f, cfg.time_scale);
+            Profiler::Scope timer(Profiler::Stage::Integration);
             integrate(w, dtEff);
         });
 
         // Trails update after integration
         w.system<>().kind(flecs::OnUpdate).iter([&](flecs::iter&) {
             if (const Config& cfg = *w.get<Config>(); cfg.paused) return;
+            Profiler::Scope timer(Profiler::Stage::Trails);
             update_trails(w);
         });
     }
@@ -93,13 +115,14 @@ public:
                       const bool pinned) {
             w.entity()
                 .set<Position>({dvec2(pos)})
+                .set<PrevPosition>({dvec2(pos)})
                 .set<Velocity>({dvec2(vel)})
                 .set<Acceleration>({DVec2{0.0, 0.0}})
                 .set<PrevAcceleration>({DVec2{0.0, 0.0}})
                 .set<Mass>({mass})
                 .set<Pinned>({pinned})
                 .set<Tint>({col})
-                .set<Trail>({{}})
+                .set<Trail>({})
                 .add<Selectable>()
                 .set<Draggable>({true, constants::drag_vel_scale});
         };
@@ -114,9 +137,57 @@ public:
         zero_net_momentum(w);
     }
 
+    // Hermite evaluates its own forces (with jerk) inside integrate(), so a separate gravity pass would be wasted.
+    [[nodiscard]] static bool needs_gravity_pass(const Config& cfg) { return cfg.integrator != 2; }
+
+    // Hermite forces and jerks to start from instead of evaluating them, set as a world singleton when a checkpoint
+    // is restored. Element k belongs to ids[k], the k-th restored body; the next integrate() consumes it, and uses it
+    // only while every body and G / softening still match it exactly.
+    struct HermiteSeed {
+        std::vector<flecs::entity_t> ids;
+        std::vector<DVec2> x, v, a, jerk;
+        std::vector<float> masses;
+        std::vector<uint8_t> pins;
+        double G = 0.0;
+        double eps2 = 0.0;
+    };
+
+    // Copy the carried-over Hermite accelerations and jerks of the bodies ids (in that order; zero for bodies
+    // Hermite skips) into acc / jerk. False, leaving both untouched, unless the last integrate() was Hermite and
+    // the world is still exactly what it left. Call on the simulation thread, where the state lives.
+    static bool export_hermite(const flecs::world& w, const std::vector<flecs::entity_t>& ids,
+                               std::vector<Acceleration>& acc, std::vector<DVec2>& jerk) {
+        const Config* cfg = w.get<Config>();
+        Scratch::Hermite& h = scratch().hermite;
+        if (!cfg || cfg->integrator != 2 || !h.forces_valid || h.G != cfg->g ||
+            h.eps2 != static_cast<double>(cfg->softening) * static_cast<double>(cfg->softening))
+            return false;
+        bool same = true;
+        size_t n = 0;
+        w.each([&](const flecs::entity e, const Position& p, const Velocity& v, const Mass& m, const Pinned& pin) {
+            if (!same || !hermite_body(p, v, m)) return;
+            same = n < h.ids.size() && h.ids[n] == e.id() && h.x[n].x == p.value.x && h.x[n].y == p.value.y &&
+                h.v[n].x == v.value.x && h.v[n].y == v.value.y && h.masses[n] == m.value &&
+                h.pins[n] == (pin.value ? 1 : 0);
+            ++n;
+        });
+        if (!same || n != h.ids.size() || h.a.size() != n || h.jerk.size() != n) return false;
+
+        sort_ids(h.ids, h.lookup);
+        acc.assign(ids.size(), Acceleration{DVec2{0.0, 0.0}});
+        jerk.assign(ids.size(), DVec2{0.0, 0.0});
+        for (size_t k = 0; k < ids.size(); ++k) {
+            if (const size_t i = find_id(h.lookup, ids[k]); i < n) {
+                acc[k].value = h.a[i];
+                jerk[k] = h.jerk[i];
+            }
+        }
+        return true;
+    }
+
     static bool compute_diagnostics(const flecs::world& w, const double G, const double eps2, Diagnostics& out) {
-        std::vector<std::tuple<DVec2, DVec2, float>> data;
-        data.reserve(1024);
+        auto& data = scratch().diagnostics;
+        data.clear();
         w.each(
             [&](const Position& p, const Velocity& v, const Mass& m) { data.emplace_back(p.value, v.value, m.value); });
         const size_t n = data.size();
@@ -178,83 +249,111 @@ public:
     // No backward-compatible aliases: use snake_case API
 
 private:
+    static inline int s_steps_since_diagnostics = 0;
+
     static inline bool is_finite(const float v) { return std::isfinite(static_cast<double>(v)); }
 
-    static void compute_gravity(const flecs::world& w) {
-        const Config& cfg = *w.get<Config>();
-        const double G = cfg.g;
-        const double eps2 = static_cast<double>(cfg.softening) * static_cast<double>(cfg.softening);
+    // Bodies the Hermite integrator advances; the rest are left untouched.
+    static bool hermite_body(const Position& p, const Velocity& v, const Mass& m) {
+        return std::isfinite(p.value.x) && std::isfinite(p.value.y) && std::isfinite(v.value.x) &&
+            std::isfinite(v.value.y) && m.value > 0.0f && is_finite(m.value);
+    }
 
+    // (id, index) pairs sorted by id, for matching bodies across two orders.
+    using IdLookup = std::vector<std::pair<flecs::entity_t, size_t>>;
+    static void sort_ids(const std::vector<flecs::entity_t>& ids, IdLookup& out) {
+        out.clear();
+        for (size_t i = 0; i < ids.size(); ++i) out.emplace_back(ids[i], i);
+        std::sort(out.begin(), out.end());
+    }
+    // Index of id, or SIZE_MAX when absent.
+    static size_t find_id(const IdLookup& lookup, const flecs::entity_t id) {
+        const auto it = std::lower_bound(lookup.begin(), lookup.end(), std::pair<flecs::entity_t, size_t>{id, 0});
+        return it != lookup.end() && it->first == id ? it->second : SIZE_MAX;
+    }
+
+    // Gather buffers of the per-step kernels, kept per thread (the UI may compute diagnostics too) and reused so
+    // steady-state steps do not allocate.
+    struct Scratch {
         std::vector<DVec2> positions;
         std::vector<float> masses;
         std::vector<uint8_t> pins;
         std::vector<Acceleration*> accPtrs;
-        positions.reserve(1000);
-        masses.reserve(1000);
-        pins.reserve(1000);
-        accPtrs.reserve(1000);
-
-        w.each([&](Position& p, Velocity& v, Mass& m, Pinned& pin, Acceleration& a) {
-            if (std::isfinite(p.value.x) && std::isfinite(p.value.y) && std::isfinite(v.value.x) &&
-                std::isfinite(v.value.y) && m.value > 0.0f && std::isfinite(static_cast<double>(m.value))) {
-                positions.push_back(p.value);
-                masses.push_back(m.value);
-                pins.push_back(pin.value ? 1 : 0);
-                accPtrs.push_back(&a);
-            }
-        });
+        std::vector<DVec2> acc;
+        std::vector<std::tuple<DVec2, DVec2, float>> diagnostics;
+
+        // Hermite: state at the start of the substep (x, v, a, jerk), prediction (xp, vp) and forces there (a1, j1).
+        // Unlike the buffers above these persist between frames: the last substep's forces start the next frame
+        // while forces_valid holds, i.e. while the bodies, their state and G / softening are what this left them.
+        struct Hermite {
+            std::vector<flecs::entity_t> ids;
+            std::vector<DVec2> x, v, a, jerk, xp, vp, a1, j1;
+            std::vector<float> masses;
+            std::vector<uint8_t> pins;
+            std::vector<Position*> posPtrs;
+            std::vector<Velocity*> velPtrs;
+            std::vector<Acceleration*> accPtrs;
+            IdLookup lookup;  // checkpoint export / seed matching only
+            double G = 0.0;
+            double eps2 = 0.0;
+            bool forces_valid = false;
+        };
+        Hermite hermite;
+    };
+    static auto scratch() -> Scratch& {
+        static thread_local Scratch s;
+        return s;
+    }
+
+public:
+    // Per-step kernels behind the systems above; nbody_bench also drives them directly.
+    // Profiled as gravity walk, except gathering the arrays and building the tree, which count as gravity build.
+    static void compute_gravity(const flecs::world& w) {
+        Profiler::Scope timer(Profiler::Stage::GravityWalk);
+        const Config& cfg = *w.get<Config>();
+        const double G = cfg.g;
+        const double eps2 = static_cast<double>(cfg.softening) * static_cast<double>(cfg.softening);
+
+        Scratch& buf = scratch();
+        auto& positions = buf.positions;
+        auto& masses = buf.masses;
+        auto& pins = buf.pins;
+        auto& accPtrs = buf.accPtrs;
+        auto* tree = cfg.tree_aggregate ? w.get_mut<GravityTree>() : nullptr;
+        if (tree) {
+            tree->cells.clear();
+            tree->entities.clear();
+        }
+        {
+            Profiler::Scope gather(Profiler::Stage::GravityBuild);
+            positions.clear();
+            masses.clear();
+            pins.clear();
+            accPtrs.clear();
+
+            w.each([&](const flecs::entity e, Position& p, Velocity& v, Mass& m, Pinned& pin, Acceleration& a) {
+                if (std::isfinite(p.value.x) && std::isfinite(p.value.y) && std::isfinite(v.value.x) &&
+                    std::isfinite(v.value.y) && m.value > 0.0f && std::isfinite(static_cast<double>(m.value))) {
+                    positions.push_back(p.value);
+                    masses.push_back(m.value);
+                    pins.push_back(pin.value ? 1 : 0);
+                    accPtrs.push_back(&a);
+                    if (tree) tree->entities.push_back(e.id());
+                }
+            });
+        }
 
         const size_t n = positions.size();
         if (n == 0) return;
 
-        std::vector acc(n, DVec2{0.0, 0.0});
+        auto& acc = buf.acc;
+        acc.assign(n, DVec2{0.0, 0.0});
 
         if (n > static_cast<size_t>(cfg.bh_threshold)) {
-            std::vector<SpatialPartition::Body> bodies;
-            bodies.reserve(n);
-            for (size_t i = 0; i < n; ++i)
-                bodies.push_back(
-                    {raylib::Vector2{static_cast<float>(positions[i].x), static_cast<float>(positions[i].y)}, masses[i],
-                     static_cast<int>(i)});
-
-            SpatialPartition tree;
-            tree.build(bodies);
-            const double theta = static_cast<double>(cfg.bh_theta);
-
-            for (size_t i = 0; i < n; ++i) {
-                if (pins[i]) continue;
-                raylib::Vector2 af{0.0f, 0.0f};
-                tree.compute_force(bodies[i], theta, G, eps2, af);
-                acc[i].x += static_cast<double>(af.x);
-                acc[i].y += static_cast<double>(af.y);
-            }
+            Gravity::barnes_hut(positions, masses, pins, G, eps2, static_cast<double>(cfg.bh_theta), acc,
+                                tree ? &tree->cells : nullptr);
         } else {
-            const DVec2* pos = positions.data();
-            const float* mass = masses.data();
-            const uint8_t* pin = pins.data();
-            for (size_t i = 0; i < n; ++i) {
-                for (size_t j = i + 1; j < n; ++j) {
-                    const double dx = pos[j].x - pos[i].x;
-                    const double dy = pos[j].y - pos[i].y;
-                    const double r2 = dx * dx + dy * dy + eps2;
-                    const double invR = 1.0 / std::sqrt(r2);
-                    const double invR3 = invR * invR * invR;
-
-                    const double ax_i = G * static_cast<double>(mass[j]) * dx * invR3;
-                    const double ay_i = G * static_cast<double>(mass[j]) * dy * invR3;
-                    const double ax_j = -G * static_cast<double>(mass[i]) * dx * invR3;
-                    const double ay_j = -G * static_cast<double>(mass[i]) * dy * invR3;
-
-                    if (!pin[i]) {
-                        acc[i].x += ax_i;
-                        acc[i].y += ay_i;
-                    }
-                    if (!pin[j]) {
-                        acc[j].x += ax_j;
-                        acc[j].y += ay_j;
-                    }
-                }
-            }
+            Gravity::direct(positions, masses, pins, G, eps2, acc);
         }
 
         for (size_t i = 0; i < n; ++i) accPtrs[i]->value = acc[i];
@@ -270,7 +369,14 @@ private:
         nSteps = std::max(1, std::min(nSteps, std::max(1, cfg.max_substeps_per_frame)));
         const float dtSub = dt / static_cast<float>(nSteps);
 
-        if (const int integrator = cfg.integrator; integrator == 0) {
+        if (const auto* seed = w.get<HermiteSeed>()) {
+            if (cfg.integrator == 2) adopt_hermite_seed(w, *seed);
+            w.remove<HermiteSeed>();
+        }
+
+        if (const int integrator = cfg.integrator; integrator == 2) {
+            integrate_hermite(w, cfg, nSteps, static_cast<double>(dtSub));
+        } else if (integrator == 0) {
             // Semi-Implicit Euler with substeps
             for (int step = 0; step < nSteps; ++step) {
                 w.each([&](Position& p, Velocity& v, const Acceleration& a, const Pinned& pin) {
@@ -326,14 +432,147 @@ private:
         }
     }
 
+    // Load a restored checkpoint's Hermite state into the scratch arrays, in this query's order. The gather in
+    // integrate_hermite() then checks it against the world like any carried-over state.
+    static void adopt_hermite_seed(const flecs::world& w, const HermiteSeed& seed) {
+        Scratch::Hermite& h = scratch().hermite;
+        h.forces_valid = false;
+        h.ids.clear();
+        h.x.clear();
+        h.v.clear();
+        h.a.clear();
+        h.jerk.clear();
+        h.masses.clear();
+        h.pins.clear();
+        sort_ids(seed.ids, h.lookup);
+        bool found = true;
+        w.each([&](const flecs::entity e, const Position& p, const Velocity& v, const Mass& m) {
+            if (!found || !hermite_body(p, v, m)) return;
+            const size_t k = find_id(h.lookup, e.id());
+            found = k < seed.ids.size();
+            if (!found) return;
+            h.ids.push_back(e.id());
+            h.x.push_back(seed.x[k]);
+            h.v.push_back(seed.v[k]);
+            h.a.push_back(seed.a[k]);
+            h.jerk.push_back(seed.jerk[k]);
+            h.masses.push_back(seed.masses[k]);
+            h.pins.push_back(seed.pins[k]);
+        });
+        h.G = seed.G;
+        h.eps2 = seed.eps2;
+        h.forces_valid = found;
+    }
+
+    // Fourth-order Hermite predictor-corrector (Makino & Aarseth 1992) on packed arrays. Forces and jerks come from
+    // the fused direct kernel, once per substep at the predicted state, and start the next substep; the last ones
+    // carry over to the next frame, so a step costs one O(N^2) evaluation. Anything that changed the bodies since
+    // (added, removed, merged or edited) forces a fresh evaluation at the current state. Bodies with non-finite
+    // state are left untouched.
+    static void integrate_hermite(const flecs::world& w, const Config& cfg, const int nSteps, const double dt) {
+        Scratch::Hermite& h = scratch().hermite;
+        const double G = cfg.g;
+        const double eps2 = static_cast<double>(cfg.softening) * static_cast<double>(cfg.softening);
+        const double maxSpeed = static_cast<double>(cfg.max_speed);
+
+        // Gather over last frame's arrays, checking that every body is exactly as this left it.
+        bool reuse = h.forces_valid && h.G == G && h.eps2 == eps2;
+        size_t n = 0;
+        h.posPtrs.clear();
+        h.velPtrs.clear();
+        h.accPtrs.clear();
+        w.each([&](const flecs::entity e, Position& p, Velocity& v, Mass& m, Pinned& pin, Acceleration& a) {
+            if (!hermite_body(p, v, m)) return;
+            const uint8_t pinned = pin.value ? 1 : 0;
+            if (n < h.ids.size()) {
+                reuse = reuse && h.ids[n] == e.id() && h.x[n].x == p.value.x && h.x[n].y == p.value.y &&
+                    h.v[n].x == v.value.x && h.v[n].y == v.value.y && h.masses[n] == m.value && h.pins[n] == pinned;
+                h.ids[n] = e.id();
+                h.x[n] = p.value;
+                h.v[n] = v.value;
+                h.masses[n] = m.value;
+                h.pins[n] = pinned;
+            } else {
+                reuse = false;
+                h.ids.push_back(e.id());
+                h.x.push_back(p.value);
+                h.v.push_back(v.value);
+                h.masses.push_back(m.value);
+                h.pins.push_back(pinned);
+            }
+            h.posPtrs.push_back(&p);
+            h.velPtrs.push_back(&v);
+            h.accPtrs.push_back(&a);
+            ++n;
+        });
+        reuse = reuse && n == h.ids.size();
+        h.ids.resize(n);
+        h.x.resize(n);
+        h.v.resize(n);
+        h.masses.resize(n);
+        h.pins.resize(n);
+        h.forces_valid = false;
+        if (n == 0) return;
+
+        const auto evaluate = [&](const std::vector<DVec2>& x, const std::vector<DVec2>& v, std::vector<DVec2>& a,
+                                  std::vector<DVec2>& jerk) {
+            Profiler::Scope timer(Profiler::Stage::GravityWalk);
+            a.assign(n, DVec2{0.0, 0.0});
+            jerk.assign(n, DVec2{0.0, 0.0});
+            Gravity::direct_with_jerk(x, v, h.masses, h.pins, G, eps2, a, jerk);
+        };
+
+        if (!reuse || h.a.size() != n || h.jerk.size() != n) evaluate(h.x, h.v, h.a, h.jerk);
+        h.xp.resize(n);
+        h.vp.resize(n);
+        const double dt2 = dt * dt;
+        for (int step = 0; step < nSteps; ++step) {
+            // Predict
+            for (size_t i = 0; i < n; ++i) {
+                h.xp[i] = h.x[i];
+                h.vp[i] = h.v[i];
+                if (h.pins[i]) continue;
+                h.xp[i] += h.v[i] * dt + h.a[i] * (dt2 / 2.0) + h.jerk[i] * (dt2 * dt / 6.0);
+                h.vp[i] += h.a[i] * dt + h.jerk[i] * (dt2 / 2.0);
+            }
+            evaluate(h.xp, h.vp, h.a1, h.j1);
+            // Correct
+            for (size_t i = 0; i < n; ++i) {
+                if (h.pins[i]) continue;
+                DVec2 v1 = h.v[i] + (h.a[i] + h.a1[i]) * (dt / 2.0) + (h.jerk[i] - h.j1[i]) * (dt2 / 12.0);
+                if (maxSpeed > 0.0) {
+                    const double vlen = std::sqrt(v1.x * v1.x + v1.y * v1.y);
+                    if (vlen > maxSpeed) v1 *= maxSpeed / vlen;
+                }
+                h.x[i] += (h.v[i] + v1) * (dt / 2.0) + (h.a[i] - h.a1[i]) * (dt2 / 12.0);
+                h.v[i] = v1;
+            }
+            std::swap(h.a, h.a1);
+            std::swap(h.jerk, h.j1);
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            h.posPtrs[i]->value = h.x[i];
+            h.velPtrs[i]->value = h.v[i];
+            h.accPtrs[i]->value = h.a[i];
+        }
+        h.G = G;
+        h.eps2 = eps2;
+        h.forces_valid = true;
+    }
+
     static void update_trails(const flecs::world& w) {
         const Config& cfg = *w.get<Config>();
-        if (!cfg.draw_trails) return;
-        const int maxLen = std::max(0, cfg.trail_max);
-        w.each([&](Trail& t, const Position& p) {
-            t.points.push_back(raylib::Vector2{static_cast<float>(p.value.x), static_cast<float>(p.value.y)});
-            if (static_cast<int>(t.points.size()) > maxLen) t.points.erase(t.points.begin());
+        auto* pool = w.get_mut<TrailPool>();
+        if (!cfg.draw_trails || !pool) return;
+        // Changing the length drops existing history rather than reshaping every ring.
+        pool->set_capacity(static_cast<size_t>(std::max(0, cfg.trail_max)));
+        pool->reserve(static_cast<size_t>(w.count<Trail>()));
+        w.each([&](const flecs::entity e, Trail& t, const Position& p) {
+            if (!pool->owned_by(t.slot, e.id())) t.slot = pool->acquire(e.id());
+            pool->push(t.slot, static_cast<float>(p.value.x), static_cast<float>(p.value.y));
         });
+        pool->sweep();
     }
 };
 
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <flecs.h>
+#include <string>
+
+#include "../core/Config.hpp"
+#include "../core/Constants.hpp"
+#include "../core/RenderSnapshot.hpp"
+#include "../core/TrailPool.hpp"
+#include "../core/Trajectory.hpp"
+
+namespace nbody {
+
+// Plays back a recorded trajectory instead of the live simulation.
+// - The file is memory-mapped; only the chunk under the playhead is decoded (plus one prefetched ahead), so
+//   files far larger than RAM scrub interactively.
+// - Each shown frame is turned into a RenderSnapshot and drawn through the normal renderer; while active, the
+//   simulation thread does not step (see Simulation::run).
+// Everything except active() runs on the main thread.
+class Playback {
+public:
+    static bool open(const std::filesystem::path& path) {
+        close();
+        if (!s_reader.open(path)) return false;
+        s_frame = 0;
+        s_playhead = 0.0;
+        s_shown = kNoFrame;
+        s_playing = false;
+        s_active.store(true, std::memory_order_release);
+        return true;
+    }
+
+    static void close() {
+        s_active.store(false, std::memory_order_release);
+        s_reader.close();
+        s_snapshot.clear();
+    }
+
+    [[nodiscard]] static auto active() -> bool { return s_active.load(std::memory_order_acquire); }
+    [[nodiscard]] static auto reader() -> const trajectory::Reader& { return s_reader; }
+    [[nodiscard]] static auto frame() -> std::uint64_t { return s_frame; }
+    [[nodiscard]] static auto playing() -> bool { return s_playing; }
+    static void set_playing(const bool playing) { s_playing = playing; }
+
+    // Frames advanced per second of wall time while playing (negative plays backwards).
+    [[nodiscard]] static auto speed() -> float& { return s_speed; }
+
+    static void seek(const std::uint64_t frame) {
+        if (s_reader.frame_count() == 0) return;
+        s_frame = std::min(frame, s_reader.frame_count() - 1);
+        s_playhead = static_cast<double>(s_frame);
+    }
+
+    // Advance the playhead, decode the frame under it if it changed, and pick up the current visual settings.
+    // Call once per rendered frame with the world held (for Config).
+    static void update(const flecs::world& w, const float frameDt) {
+        if (!active()) return;
+        const std::uint64_t count = s_reader.frame_count();
+        if (s_playing && count > 1) {
+            s_playhead = std::clamp(s_playhead + static_cast<double>(s_speed) * static_cast<double>(frameDt), 0.0,
+                                    static_cast<double>(count - 1));
+            s_frame = static_cast<std::uint64_t>(std::floor(s_playhead));
+            if ((s_speed >= 0.0F && s_frame == count - 1) || (s_speed < 0.0F && s_frame == 0)) s_playing = false;
+        }
+        if (const auto* cfg = w.get<Config>()) s_snapshot.cfg = *cfg;
+        if (s_frame == s_shown) return;
+        trajectory::Reader::FrameView view{};
+        if (!s_reader.frame(s_frame, view)) return;
+        build_snapshot(view);
+        s_shown = s_frame;
+    }
+
+    [[nodiscard]] static auto snapshot() -> const RenderSnapshot& { return s_snapshot; }
+
+private:
+    static constexpr std::uint64_t kNoFrame = ~std::uint64_t{0};
+
+    static inline std::atomic<bool> s_active{false};
+    static inline trajectory::Reader s_reader;
+    static inline RenderSnapshot s_snapshot;
+    static inline std::uint64_t s_frame = 0;
+    static inline std::uint64_t s_shown = kNoFrame;
+    static inline double s_playhead = 0.0;
+    static inline bool s_playing = false;
+    static inline float s_speed = constants::default_playback_fps;
+
+    static void build_snapshot(const trajectory::Reader::FrameView& f) {
+        RenderSnapshot& s = s_snapshot;
+        const std::size_t n = f.body_count();
+        s.sim_time = f.header->sim_time;
+        s.step = f.header->step;
+        s.interp_step_s = 0.0;
+
+        // Radii and draw order only depend on the body set and masses, which rarely change between frames.
+        bool sameBodies =
+            s.ids.size() == n && (n == 0 || std::memcmp(s.ids.data(), f.ids(), n * sizeof(std::uint64_t)) == 0);
+        s.ids.resize(n);
+        s.masses.resize(n);
+        s.tints.resize(n);
+        std::memcpy(s.ids.data(), f.ids(), n * sizeof(std::uint64_t));
+        const std::uint64_t* attributes = f.attributes();
+        for (std::size_t i = 0; i < n; ++i) {
+            const float m = trajectory::unpack_mass(attributes[i]);
+            sameBodies = sameBodies && s.masses[i] == m;
+            s.masses[i] = m;
+            s.tints[i] = trajectory::unpack_tint(attributes[i]);
+        }
+        s.positions.resize(n);
+        std::memcpy(static_cast<void*>(s.positions.data()), f.position_words(), n * sizeof(DVec2));
+        s.prev_positions = s.positions;
+        s.accelerations.assign(n, DVec2{});
+        s.trail_slots.assign(n, TrailPool::kNoSlot);
+        if (sameBodies && s.radii.size() == n) return;
+
+        s.radii.resize(n);
+        s.max_radius = 0.0F;
+        for (std::size_t i = 0; i < n; ++i) {
+            s.radii[i] = RenderSnapshot::radius_for_mass(s.masses[i]);
+            s.max_radius = std::max(s.max_radius, s.radii[i]);
+        }
+        s.draw_order.resize(n);
+        for (std::uint32_t i = 0; i < s.draw_order.size(); ++i) s.draw_order[i] = i;
+        std::sort(s.draw_order.begin(), s.draw_order.end(),
+                  [&](const std::uint32_t a, const std::uint32_t b) { return s.masses[a] > s.masses[b]; });
+    }
+};
+
+}  // namespace nbody
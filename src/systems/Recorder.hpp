@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <flecs.h>
+#include <memory>
+#include <string>
+
+#include "../components/Components.hpp"
+#include "../core/Config.hpp"
+#include "../core/Constants.hpp"
+#include "../core/ScenarioFile.hpp"
+#include "../core/Trajectory.hpp"
+
+namespace nbody {
+
+// Streams body trajectories to a *.nbtraj file while the simulation runs.
+// - Every Config::record_interval steps the simulation thread copies ids, positions, velocities, masses and tints
+//   into a pooled frame buffer (one pass, no allocation once the buffers have grown) and queues it.
+// - Delta encoding, compression and disk writes happen on the trajectory writer's own thread.
+// - If the writer falls behind and every buffer is queued, samples are dropped and counted rather than stalling
+//   the step loop.
+// State is touched only by the simulation thread or by the UI while it holds the world.
+class Recorder {
+public:
+    // Begin recording into a new file under recordings_dir(). Run on the simulation thread (Simulation::submit).
+    static void start(const flecs::world& w) {
+        const auto* cfg = w.get<Config>();
+        if (!cfg || s_writer) return;
+        // Chunks hold about record_chunk_bytes of raw frames, so huge scenes still get frequent index points; frames
+        // delta across chunk boundaries, with a keyframe every record_keyframe_chunks chunks.
+        const auto bodies = static_cast<std::size_t>(std::max<std::int64_t>(1, w.count<Position>()));
+        const std::size_t frameBytes = bodies * trajectory::kWordsPerBody * sizeof(std::uint64_t);
+        const auto framesPerChunk = static_cast<std::uint32_t>(std::clamp<std::size_t>(
+            constants::record_chunk_bytes / frameBytes, 1, constants::record_frames_per_chunk_max));
+        auto writer = std::make_unique<trajectory::Writer>();
+        if (!writer->open(new_path(), static_cast<std::uint32_t>(std::max(1, cfg->record_interval)), framesPerChunk,
+                          constants::record_keyframe_chunks, constants::record_queue_depth)) {
+            s_last_error = "could not create recording file";
+            return;
+        }
+        s_last_error.clear();
+        s_writer = std::move(writer);
+    }
+
+    // Flush queued frames and finalize the file (index + footer). Run on the simulation thread, or after it stopped.
+    static void stop(const flecs::world& /*w*/) {
+        if (!s_writer) return;
+        s_writer->close();
+        s_last_path = s_writer->path().string();
+        s_writer.reset();
+    }
+
+    // Called by the simulation after every step.
+    static void capture(const flecs::world& w, const std::uint64_t step, const double simTime) {
+        if (!s_writer || step % s_writer->record_interval() != 0) return;
+        trajectory::Frame* f = s_writer->acquire();
+        if (!f) return;
+        f->step = step;
+        f->sim_time = simTime;
+        w.each([&](const flecs::entity e, const Position& p, const Velocity& v, const Mass& m, const Tint& t) {
+            f->ids.push_back(e.id());
+            f->positions.push_back(p.value);
+            f->velocities.push_back(v.value);
+            f->attributes.push_back(trajectory::pack_attributes(m.value, t.value));
+        });
+        s_writer->submit(f);
+    }
+
+    [[nodiscard]] static auto recording() -> bool { return s_writer != nullptr; }
+    [[nodiscard]] static auto writer() -> const trajectory::Writer* { return s_writer.get(); }
+    [[nodiscard]] static auto last_path() -> const std::string& { return s_last_path; }
+    [[nodiscard]] static auto last_error() -> const std::string& { return s_last_error; }
+
+    static std::filesystem::path recordings_dir() { return ScenarioFile::scenario_dir().parent_path() / "recordings"; }
+
+private:
+    static inline std::unique_ptr<trajectory::Writer> s_writer;
+    static inline std::string s_last_path;
+    static inline std::string s_last_error;
+
+    static std::filesystem::path new_path() {
+        return ScenarioFile::timestamped_path(recordings_dir(), "run", trajectory::kExtension);
+    }
+};
+
+}  // namespace nbody
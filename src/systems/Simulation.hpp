@@ -0,0 +1,321 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <flecs.h>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../components/Components.hpp"
+#include "../core/Config.hpp"
+#include "../core/Constants.hpp"
+#include "../core/Profiler.hpp"
+#include "../core/RenderSnapshot.hpp"
+#include "../core/TripleBuffer.hpp"
+#include "Checkpointer.hpp"
+#include "Governor.hpp"
+#include "Physics.hpp"
+#include "Playback.hpp"
+#include "Recorder.hpp"
+
+namespace nbody {
+
+// Runs world.progress() on a dedicated thread and publishes RenderSnapshots through a lock-free triple buffer.
+// - The renderer only ever reads the latest snapshot and never touches the ECS world.
+// - UI/input code touches the world between simulation steps via lock_world(); edits that rebuild or step the
+//   world are queued with submit() and applied by the simulation thread before its next step.
+class Simulation {
+public:
+    using Command = std::function<void(const flecs::world&)>;
+
+    // World singleton so systems that only receive the world can reach the command queue.
+    struct Handle {
+        Simulation* sim = nullptr;
+    };
+
+    explicit Simulation(const flecs::world& world) : world_(world) {}
+    ~Simulation() { stop(); }
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    void start() {
+        if (thread_.joinable()) return;
+        world_.set<Handle>({this});
+        running_.store(true, std::memory_order_release);
+        thread_ = std::thread([this] { run(); });
+    }
+
+    // Resume the simulation clock from a checkpoint; call before start().
+    void restore_clock(const std::uint64_t steps, const double simTime) {
+        steps_ = steps;
+        sim_time_ = simTime;
+    }
+
+    void stop() {
+        running_.store(false, std::memory_order_release);
+        if (thread_.joinable()) thread_.join();
+        world_.set<Handle>({nullptr});
+    }
+
+    // Hold the world between simulation steps. The simulation thread yields while a waiter is pending,
+    // so the caller waits for at most the step that is currently in flight.
+    [[nodiscard]] auto lock_world() -> std::unique_lock<std::mutex> {
+        waiters_.fetch_add(1, std::memory_order_acq_rel);
+        std::unique_lock lock(world_mutex_);
+        waiters_.fetch_sub(1, std::memory_order_acq_rel);
+        return lock;
+    }
+
+    void push(Command cmd) {
+        std::scoped_lock lock(queue_mutex_);
+        pending_.push_back(std::move(cmd));
+    }
+
+    // Queue a world edit on the simulation thread, or apply it immediately when no simulation thread runs.
+    static void submit(const flecs::world& w, Command cmd) {
+        if (const auto* h = w.get<Handle>(); h && h->sim) {
+            h->sim->push(std::move(cmd));
+            return;
+        }
+        cmd(w);
+    }
+
+    // Consumer side: latest published snapshot; stays valid until the next call.
+    [[nodiscard]] auto latest_snapshot() -> const RenderSnapshot& {
+        snapshots_.update();
+        return snapshots_.read_buffer();
+    }
+
+private:
+    using Clock = RenderSnapshot::Clock;
+    static constexpr double kMsPerSec = 1000.0;
+
+    const flecs::world& world_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<int> waiters_{0};
+    std::mutex world_mutex_;
+    std::mutex queue_mutex_;
+    std::vector<Command> pending_;
+    std::vector<Command> executing_;
+    TripleBuffer<RenderSnapshot> snapshots_;
+    double sim_time_ = 0.0;
+    std::uint64_t steps_ = 0;
+    static constexpr std::uint32_t kNoSlot = ~std::uint32_t{0};
+    std::vector<std::uint32_t> slot_of_entity_;  // scratch for build_tree
+    std::vector<std::uint32_t> order_;  // last draw order and the bodies/masses it was sorted for
+    std::vector<flecs::entity_t> order_ids_;
+    std::vector<float> order_masses_;
+
+    void run() {
+        Profiler::name_thread("Simulation");
+        auto lastTick = Clock::now();
+        double accumulator = 0.0;  // wall seconds not yet simulated
+        while (running_.load(std::memory_order_acquire)) {
+            wait_for_ui();
+            const auto now = Clock::now();
+            const double wall = std::min(std::chrono::duration<double>(now - lastTick).count(),
+                                         static_cast<double>(constants::sim_max_wall_dt));
+            lastTick = now;
+
+            Config cfg{};
+            {
+                std::scoped_lock lock(world_mutex_);
+                drain_commands();
+                if (const auto* c = world_.get<Config>()) cfg = *c;
+            }
+
+            if (Playback::active()) {
+                // Reviewing a recording: the renderer draws the file, physics stays put.
+                accumulator = 0.0;
+                std::this_thread::sleep_for(std::chrono::milliseconds(constants::sim_idle_sleep_ms));
+                continue;
+            }
+
+            if (cfg.paused) {
+                accumulator = 0.0;
+                publish(0.0, 0.0);
+                // Keep publishing edits made while paused, without spinning a core.
+                std::this_thread::sleep_for(std::chrono::milliseconds(constants::sim_idle_sleep_ms));
+                continue;
+            }
+
+            if (!cfg.use_fixed_dt) {
+                // Variable step: one step covering the elapsed wall time, as often as the CPU allows.
+                step(static_cast<float>(wall));
+                publish(0.0, 0.0);
+                continue;
+            }
+
+            // Fixed step: run as many fixed_dt steps as the accumulated wall time allows, within the CPU budget.
+            const double h = std::max(static_cast<double>(constants::fixed_dt_min), static_cast<double>(cfg.fixed_dt));
+            accumulator += wall;
+            const auto budgetEnd = now + std::chrono::duration<double, std::milli>(cfg.step_budget_ms);
+            while (accumulator >= h && running_.load(std::memory_order_acquire)) {
+                if (Clock::now() >= budgetEnd) {
+                    // Too far behind: drop whole steps instead of spiralling, keep the sub-step remainder.
+                    const double dropped = std::floor(accumulator / h) * h;
+                    accumulator -= dropped;
+                    std::scoped_lock lock(world_mutex_);
+                    if (auto* c = world_.get_mut<Config>()) c->dropped_ms += dropped * kMsPerSec;
+                    break;
+                }
+                wait_for_ui();
+                step(static_cast<float>(h));
+                accumulator -= h;
+            }
+            publish(accumulator, h);
+
+            // Nothing is due until the accumulator reaches the next whole step.
+            std::this_thread::sleep_until(Clock::now() + std::chrono::duration<double>(h - accumulator));
+        }
+    }
+
+    void wait_for_ui() const {
+        while (waiters_.load(std::memory_order_acquire) > 0) std::this_thread::yield();
+    }
+
+    // One physics step of dt wall seconds (Physics applies time_scale).
+    void step(const float dt) {
+        Profiler::Zone zone("Physics step");
+        std::scoped_lock lock(world_mutex_);
+        drain_commands();
+        const auto* cfg = world_.get<Config>();
+        if (!cfg || cfg->paused) return;
+        // Remember where bodies were so the renderer can interpolate towards the new state.
+        world_.each([](const Position& p, PrevPosition& prev) { prev.value = p.value; });
+        const auto stepStart = Clock::now();
+        [[maybe_unused]] auto progress = world_.progress(dt);
+        const double stepMs = std::chrono::duration<double>(Clock::now() - stepStart).count() * kMsPerSec;
+        if (auto* c = world_.get_mut<Config>()) {
+            c->last_step_ms = stepMs;
+            sim_time_ += static_cast<double>(dt) * static_cast<double>(std::max(0.0F, c->time_scale));
+        }
+        Governor::update(world_, stepMs);
+        ++steps_;
+        Recorder::capture(world_, steps_, sim_time_);
+        Checkpointer::capture(world_, steps_, sim_time_);
+    }
+
+    // leftover: wall seconds accumulated past the last step; stepDt: wall seconds per step (0 = no interpolation)
+    void publish(const double leftover, const double stepDt) {
+        Profiler::Zone zone("Publish snapshot");
+        {
+            std::scoped_lock lock(world_mutex_);
+            RenderSnapshot& s = snapshots_.write_buffer();
+            build_snapshot(s);
+            s.interp_leftover_s = leftover;
+            s.interp_step_s = (stepDt > 0.0 && s.cfg.interpolate_render) ? stepDt : 0.0;
+            s.published_at = Clock::now();
+        }
+        snapshots_.publish();
+    }
+
+    void drain_commands() {
+        {
+            std::scoped_lock lock(queue_mutex_);
+            executing_.swap(pending_);
+        }
+        for (auto& cmd : executing_) cmd(world_);
+        executing_.clear();
+    }
+
+    void build_snapshot(RenderSnapshot& s) {
+        s.clear();
+        if (const auto* cfg = world_.get<Config>()) s.cfg = *cfg;
+        s.sim_time = sim_time_;
+        s.step = steps_;
+
+        const bool withTrails = s.cfg.draw_trails;
+        world_.each([&](const flecs::entity e, const Position& p, const Acceleration& a, const Mass& m,
+                        const Tint& tint, const PrevPosition* prev, const Radius* rad, const Trail* trail) {
+            const float rMeters = rad ? static_cast<float>(rad->value) : RenderSnapshot::radius_for_mass(m.value);
+            s.ids.push_back(e.id());
+            s.positions.push_back(p.value);
+            s.prev_positions.push_back(prev ? prev->value : p.value);
+            s.accelerations.push_back(a.value);
+            s.masses.push_back(m.value);
+            s.radii.push_back(rMeters);
+            s.max_radius = std::max(s.max_radius, rMeters);
+            s.tints.push_back(tint.value);
+            s.trail_slots.push_back((withTrails && trail) ? trail->slot : TrailPool::kNoSlot);
+        });
+        if (const auto* pool = world_.get<TrailPool>(); withTrails && pool) s.trails.sync_from(*pool);
+        if (const auto* tree = world_.get<Physics::GravityTree>(); s.cfg.tree_aggregate && tree && !tree->cells.empty())
+            build_tree(s, *tree);
+
+        // Draw order only changes with the body set or masses; re-sort only then.
+        if (s.ids != order_ids_ || s.masses != order_masses_) {
+            order_.resize(s.ids.size());
+            for (std::uint32_t i = 0; i < order_.size(); ++i) order_[i] = i;
+            std::sort(order_.begin(), order_.end(),
+                      [&](const std::uint32_t a, const std::uint32_t b) { return s.masses[a] > s.masses[b]; });
+            order_ids_ = s.ids;
+            order_masses_ = s.masses;
+        }
+        s.draw_order = order_;
+    }
+
+    // Copy the gravity tree into the snapshot, remapping leaf bodies from entities to snapshot indices and
+    // blending tints and centres of mass bottom-up (children always follow their parent in the flat layout).
+    // Centres of mass are recomputed from the snapshot's own positions so aggregates interpolate with the bodies.
+    void build_tree(RenderSnapshot& s, const Physics::GravityTree& tree) {
+        // Dense map from entity index (low 32 bits of the id) to snapshot slot.
+        std::uint32_t maxIndex = 0;
+        for (const flecs::entity_t id : s.ids) maxIndex = std::max(maxIndex, static_cast<std::uint32_t>(id));
+        slot_of_entity_.assign(static_cast<std::size_t>(maxIndex) + 1, kNoSlot);
+        for (std::uint32_t i = 0; i < s.ids.size(); ++i) slot_of_entity_[static_cast<std::uint32_t>(s.ids[i])] = i;
+
+        s.tree_cells = tree.cells;
+        s.tree_tints.resize(s.tree_cells.size());
+        s.tree_com.resize(s.tree_cells.size());
+        s.tree_prev_com.resize(s.tree_cells.size());
+        for (std::size_t k = s.tree_cells.size(); k-- > 0;) {
+            SpatialPartition::Cell& c = s.tree_cells[k];
+            if (c.first_child == 0) {
+                std::uint32_t slot = kNoSlot;
+                if (c.body >= 0 && static_cast<std::size_t>(c.body) < tree.entities.size()) {
+                    const flecs::entity_t id = tree.entities[static_cast<std::size_t>(c.body)];
+                    const auto index = static_cast<std::uint32_t>(id);
+                    if (index < slot_of_entity_.size() && slot_of_entity_[index] != kNoSlot &&
+                        s.ids[slot_of_entity_[index]] == id)
+                        slot = slot_of_entity_[index];
+                }
+                c.body = (slot == kNoSlot) ? -1 : static_cast<int>(slot);
+                s.tree_tints[k] = (slot == kNoSlot) ? BLANK : s.tints[slot];
+                const DVec2 com{c.com.x, c.com.y};
+                s.tree_com[k] = (slot == kNoSlot) ? com : s.positions[slot];
+                s.tree_prev_com[k] = (slot == kNoSlot) ? com : s.prev_positions[slot];
+                continue;
+            }
+            float r = 0.0F, g = 0.0F, b = 0.0F, total = 0.0F;
+            DVec2 com{0.0, 0.0};
+            DVec2 prevCom{0.0, 0.0};
+            for (std::uint32_t q = 0; q < 4; ++q) {
+                const std::uint32_t child = c.first_child + q;
+                const float m = s.tree_cells[child].mass;
+                const Color t = s.tree_tints[child];
+                r += m * t.r;
+                g += m * t.g;
+                b += m * t.b;
+                total += m;
+                com += s.tree_com[child] * static_cast<double>(m);
+                prevCom += s.tree_prev_com[child] * static_cast<double>(m);
+            }
+            const float inv = total > 0.0F ? 1.0F / total : 0.0F;
+            const DVec2 fallback{c.com.x, c.com.y};
+            s.tree_com[k] = total > 0.0F ? com * static_cast<double>(inv) : fallback;
+            s.tree_prev_com[k] = total > 0.0F ? prevCom * static_cast<double>(inv) : fallback;
+            s.tree_tints[k] = Color{static_cast<unsigned char>(r * inv), static_cast<unsigned char>(g * inv),
+                                    static_cast<unsigned char>(b * inv), 255};
+        }
+    }
+};
+
+}  // namespace nbody
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "../core/Profiler.hpp"
+#include "../core/ScenarioFile.hpp"
+
+namespace nbody {
+
+// Exports Profiler captures as Chrome trace-event JSON, for chrome://tracing or ui.perfetto.dev.
+// - start() arms the profiler for a number of whole frames; update(), called on the main thread after
+//   Profiler::end_frame(), writes the file once the capture completes.
+// - Each zone becomes a complete ("X") event on its thread's track, so nested scopes show as nested slices;
+//   threads are labelled through thread_name metadata.
+// State is touched only by the main thread.
+class TraceCapture {
+public:
+    // Capture the next `frames` frames into path (default: a new file under traces_dir()).
+    static void start(const int frames, std::filesystem::path path = {}) {
+        if (active() || frames <= 0) return;
+        s_pending_path = path.empty() ? new_path() : std::move(path);
+        s_last_error.clear();
+        Profiler::arm_trace(static_cast<std::size_t>(frames));
+    }
+
+    static void update() {
+        if (Profiler::trace_state() != Profiler::TraceState::Complete) return;
+        if (write(s_pending_path)) {
+            s_last_path = s_pending_path.string();
+        } else {
+            s_last_error = "could not write " + s_pending_path.string();
+        }
+        Profiler::release_trace();
+    }
+
+    [[nodiscard]] static auto active() -> bool { return Profiler::trace_state() != Profiler::TraceState::Idle; }
+    [[nodiscard]] static auto last_path() -> const std::string& { return s_last_path; }
+    [[nodiscard]] static auto last_error() -> const std::string& { return s_last_error; }
+
+    static std::filesystem::path traces_dir() { return ScenarioFile::scenario_dir().parent_path() / "traces"; }
+
+private:
+    static inline std::filesystem::path s_pending_path;
+    static inline std::string s_last_path;
+    static inline std::string s_last_error;
+
+    static auto write(const std::filesystem::path& path) -> bool {
+        std::error_code ec;
+        if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path(), ec);
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+
+        // Per thread, by start time and outermost first, so viewers nest zones that share a timestamp correctly.
+        const auto captured = Profiler::trace_events();
+        std::vector<Profiler::TraceEvent> events(captured.begin(), captured.end());
+        std::ranges::sort(events, [](const Profiler::TraceEvent& a, const Profiler::TraceEvent& b) {
+            if (a.thread != b.thread) return a.thread < b.thread;
+            if (a.begin_ns != b.begin_ns) return a.begin_ns < b.begin_ns;
+            return a.end_ns > b.end_ns;
+        });
+
+        out << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_zones\":" << Profiler::trace_dropped()
+            << "},\n\"traceEvents\":[\n";
+        out << R"({"name":"process_name","ph":"M","pid":1,"tid":0,"args":{"name":"raylib_nbody"}})";
+        for (std::uint32_t t = 0; t < Profiler::thread_count(); ++t) {
+            out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t << ",\"args\":{\"name\":\""
+                << Profiler::thread_name(t) << "\"}}";
+        }
+        std::array<char, 256> line{};
+        for (const Profiler::TraceEvent& e : events) {
+            // Microsecond timestamps with nanosecond resolution
+            std::snprintf(line.data(), line.size(),
+                          ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,"
+                          "\"dur\":%.3f}",
+                          e.name, e.category, e.thread, static_cast<double>(e.begin_ns) * 1e-3,
+                          static_cast<double>(e.end_ns - e.begin_ns) * 1e-3);
+            out << line.data();
+        }
+        out << "\n]}\n";
+        return static_cast<bool>(out.flush());
+    }
+
+    static std::filesystem::path new_path() {
+        return ScenarioFile::timestamped_path(traces_dir(), "trace", ".json");
+    }
+};
+
+}  // namespace nbody
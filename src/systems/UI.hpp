@@ -1,24 +1,46 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <cfloat>
+#include <cstdio>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <filesystem>
 #include <flecs.h>
+#include <functional>
+#include <future>
 #include <imgui.h>
+#include <memory>
 #include <raylib-cpp.hpp>
 #include <raymath.h>
 #include <rlImGui.h>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "../components/Components.hpp"
+#include "../core/AllocationCounter.hpp"
 #include "../core/Colors.hpp"
 #include "../core/Config.hpp"
 #include "../core/Constants.hpp"
+#include "../core/Generators.hpp"
+#include "../core/Importer.hpp"
+#include "../core/Profiler.hpp"
 #include "../core/Scenario.hpp"
+#include "../core/ScenarioFile.hpp"
+#include "../physics/Calibration.hpp"
 #include "Camera.hpp"
+#include "Checkpointer.hpp"
+#include "Governor.hpp"
 #include "Interaction.hpp"
 #include "Physics.hpp"
+#include "Playback.hpp"
+#include "Recorder.hpp"
+#include "Simulation.hpp"
+#include "TraceCapture.hpp"
+#include "WorldRenderer.hpp"
 
 namespace nbody {
 
@@ -43,7 +65,7 @@ public:
             if (IsKeyPressed(KEY_S)) perform_reset_scenario(w, *cfg);  // Reset Scenario
             if (IsKeyPressed(KEY_V)) Camera::reset_view(w);  // Reset View
             if (IsKeyPressed(KEY_C)) Camera::center_on_center_of_mass(w);  // Center View to COM
-            if (IsKeyPressed(KEY_Z)) Physics::zero_net_momentum(w);  // Zero Momentum
+            if (IsKeyPressed(KEY_Z)) Simulation::submit(w, Physics::zero_net_momentum);  // Zero Momentum
         }
 
         draw_time_integrator_panel(w, *cfg, requestStep);
@@ -52,6 +74,7 @@ public:
         draw_add_edit_panel(w, cam);
         draw_bodies_panel(w, pendingSelection);
         draw_diagnostics_panel(w, *cfg);
+        draw_profiler_panel();
         draw_scenarios_panel(w);
 
         if (pendingSelection.is_alive() ||
@@ -60,10 +83,14 @@ public:
         }
 
         if (requestStep) {
-            const bool old = cfg->paused;
-            cfg->paused = false;
-            w.progress(cfg->fixed_dt);
-            cfg->paused = old;
+            Simulation::submit(w, [](const flecs::world& sw) {
+                auto* c = sw.get_mut<Config>();
+                if (!c) return;
+                const bool old = c->paused;
+                c->paused = false;
+                sw.progress(c->fixed_dt);
+                if (auto* after = sw.get_mut<Config>()) after->paused = old;
+            });
         }
     }
 
@@ -103,22 +130,185 @@ private:
             ImGui::EndPopup();
         }
         ImGui::Checkbox("Use Fixed dt", &cfg.use_fixed_dt);
+        ImGui::SameLine();
+        ImGui::Checkbox("Interpolate", &cfg.interpolate_render);
         ImGui::SliderFloat("Fixed dt", &cfg.fixed_dt, nbody::constants::fixed_dt_min, nbody::constants::fixed_dt_max,
                            "%.6f");
+        ImGui::SliderFloat("Step Budget (ms)", &cfg.step_budget_ms, nbody::constants::step_budget_ms_min,
+                           nbody::constants::step_budget_ms_max, "%.1f");
         ImGui::SliderFloat("Time Scale", &cfg.time_scale, nbody::constants::time_scale_min,
                            nbody::constants::time_scale_max, "%.2e", ImGuiSliderFlags_Logarithmic);
         ImGui::RadioButton("Semi-Implicit Euler", &cfg.integrator, 0);
         ImGui::SameLine();
         ImGui::RadioButton("Velocity Verlet", &cfg.integrator, 1);
+        ImGui::SameLine();
+        ImGui::RadioButton("Hermite 4th", &cfg.integrator, 2);
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Fourth-order predictor-corrector. Always uses direct O(N^2) forces, so it suits "
+                              "small systems where accuracy matters more than body count.");
+        }
         if (ImGui::CollapsingHeader("Advanced Stability", ImGuiTreeNodeFlags_DefaultOpen)) {
             ImGui::SliderFloat("Max Substep (s)", &cfg.max_substep, 0.01f, 3600.0f, "%.2f",
                                ImGuiSliderFlags_Logarithmic);
             ImGui::SliderInt("Max Substeps / Frame", &cfg.max_substeps_per_frame, 1, 2000);
+            ImGui::SliderInt("Diagnostics Every N Steps", &cfg.diagnostics_interval, 1,
+                             nbody::constants::diagnostics_interval_max);
         }
+        draw_governor_section(w, cfg);
+        draw_recording_section(w, cfg);
+        draw_playback_section();
+        draw_checkpoint_section(cfg);
         ImGui::Text("Last step: %.3f ms", cfg.last_step_ms);
+        if (cfg.dropped_ms > 0.0) {
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(1, 0.6f, 0.2f, 1), "Behind real time: %.0f ms dropped", cfg.dropped_ms);
+        }
         ImGui::End();
     }
 
+    static void draw_governor_section(const flecs::world& w, Config& cfg) {
+        if (!ImGui::CollapsingHeader("Frame Budget Governor")) return;
+        ImGui::Checkbox("Hold Step Budget", &cfg.governor_enabled);
+        ImGui::SliderFloat("Target (ms)", &cfg.governor_target_ms, nbody::constants::governor_target_ms_min,
+                           nbody::constants::governor_target_ms_max, "%.1f");
+        ImGui::DragFloatRange2("Theta Bounds", &cfg.governor_theta_min, &cfg.governor_theta_max, 0.01f, 0.0f,
+                               nbody::constants::governor_theta_limit, "%.2f");
+        ImGui::DragIntRange2("Substep Cap Bounds", &cfg.governor_substeps_min, &cfg.governor_substeps_max, 1.0f, 1,
+                             2000);
+        ImGui::SliderInt("Max Diagnostics Interval", &cfg.governor_diag_interval_max, 1,
+                         nbody::constants::diagnostics_interval_max);
+        if (const auto* st = w.get<Governor::State>()) {
+            ImGui::Text("Avg step: %.2f ms  (target %.1f ms)", st->ema_ms, cfg.governor_target_ms);
+            ImGui::Text("Theta %.2f  Substep cap %d  Diagnostics every %d", cfg.bh_theta, cfg.max_substeps_per_frame,
+                        cfg.diagnostics_interval);
+            ImGui::Text("Last change: %s  (%d total)", st->last_action, st->adjustments);
+        }
+    }
+
+    static void draw_recording_section(const flecs::world& w, Config& cfg) {
+        if (!ImGui::CollapsingHeader("Trajectory Recording")) return;
+        const trajectory::Writer* writer = Recorder::writer();
+        if (writer == nullptr) {
+            ImGui::SliderInt("Record Every N Steps", &cfg.record_interval, 1, nbody::constants::record_interval_max,
+                             "%d", ImGuiSliderFlags_Logarithmic);
+            if (ImGui::Button("Start Recording")) Simulation::submit(w, Recorder::start);
+            if (!Recorder::last_error().empty()) {
+                ImGui::TextColored(ImVec4(1, 0.4f, 0.3f, 1), "%s", Recorder::last_error().c_str());
+            } else if (!Recorder::last_path().empty()) {
+                ImGui::TextWrapped("Saved: %s", Recorder::last_path().c_str());
+            }
+            return;
+        }
+        if (ImGui::Button("Stop Recording")) Simulation::submit(w, Recorder::stop);
+        ImGui::SameLine();
+        ImGui::Text("every %u steps", writer->record_interval());
+        const auto& st = writer->stats();
+        const auto raw = st.raw_bytes.load(std::memory_order_relaxed);
+        const auto stored = st.stored_bytes.load(std::memory_order_relaxed);
+        constexpr double kMiB = 1024.0 * 1024.0;
+        ImGui::Text("Frames %llu  dropped %llu", static_cast<unsigned long long>(st.frames_written.load()),
+                    static_cast<unsigned long long>(st.frames_dropped.load()));
+        ImGui::Text("Written %.1f MiB (%.1fx smaller than raw)", static_cast<double>(stored) / kMiB,
+                    stored > 0 ? static_cast<double>(raw) / static_cast<double>(stored) : 0.0);
+        if (st.failed.load()) ImGui::TextColored(ImVec4(1, 0.4f, 0.3f, 1), "Write error: disk full?");
+        ImGui::TextWrapped("%s", writer->path().string().c_str());
+    }
+
+    static void draw_checkpoint_section(Config& cfg) {
+        if (!ImGui::CollapsingHeader("Checkpoints")) return;
+        ImGui::Checkbox("Periodic", &cfg.checkpoint_enabled);
+        ImGui::SameLine();
+        if (ImGui::Button("Save Now")) Checkpointer::request();
+        ImGui::SliderFloat("Every (s)", &cfg.checkpoint_interval_s, nbody::constants::checkpoint_interval_s_min,
+                           nbody::constants::checkpoint_interval_s_max, "%.0f", ImGuiSliderFlags_Logarithmic);
+        const auto& st = Checkpointer::stats();
+        if (Checkpointer::writing()) {
+            ImGui::TextDisabled("Writing...");
+        } else if (st.written.load() > 0) {
+            ImGui::Text("Last: step %llu (%.0f ms to write)", static_cast<unsigned long long>(st.last_step.load()),
+                        st.last_write_ms.load());
+        }
+        if (st.failed.load() > 0) {
+            ImGui::TextColored(ImVec4(1, 0.4f, 0.3f, 1), "%llu writes failed",
+                               static_cast<unsigned long long>(st.failed.load()));
+        }
+        ImGui::TextWrapped("Resume with --restart (%s)", Checkpointer::latest_path().string().c_str());
+    }
+
+    // Recordings found in Recorder::recordings_dir(), newest first; refreshed on demand.
+    static inline std::vector<std::filesystem::path> s_recordings;
+    static inline std::vector<std::string> s_recording_names;  // file names of s_recordings, for the combo
+    static inline int s_recording_index = 0;
+    static inline bool s_recordings_listed = false;
+    static inline std::string s_playback_error;
+
+    static void list_recordings() {
+        s_recordings.clear();
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(Recorder::recordings_dir(), ec)) {
+            if (entry.is_regular_file() && entry.path().extension() == trajectory::kExtension)
+                s_recordings.push_back(entry.path());
+        }
+        std::sort(s_recordings.begin(), s_recordings.end(), std::greater<>());
+        s_recording_names.clear();
+        for (const auto& path : s_recordings) s_recording_names.push_back(path.filename().string());
+        s_recording_index = 0;
+        s_recordings_listed = true;
+    }
+
+    static void draw_playback_section() {
+        if (!ImGui::CollapsingHeader("Trajectory Playback")) return;
+        if (!Playback::active()) {
+            if (!s_recordings_listed) list_recordings();
+            if (ImGui::Button("Refresh")) list_recordings();
+            if (s_recordings.empty()) {
+                ImGui::SameLine();
+                ImGui::TextDisabled("No recordings yet");
+                return;
+            }
+            s_recording_index = std::clamp(s_recording_index, 0, static_cast<int>(s_recordings.size()) - 1);
+            ImGui::SameLine();
+            const std::string& current = s_recording_names[static_cast<std::size_t>(s_recording_index)];
+            if (ImGui::BeginCombo("##recording", current.c_str())) {
+                for (int i = 0; i < static_cast<int>(s_recordings.size()); ++i) {
+                    const std::string& name = s_recording_names[static_cast<std::size_t>(i)];
+                    if (ImGui::Selectable(name.c_str(), i == s_recording_index)) s_recording_index = i;
+                }
+                ImGui::EndCombo();
+            }
+            if (ImGui::Button("Open") && !Playback::open(s_recordings[static_cast<std::size_t>(s_recording_index)]))
+                s_playback_error = "Could not open " + current;
+            if (!s_playback_error.empty()) ImGui::TextColored(ImVec4(1, 0.4f, 0.3f, 1), "%s", s_playback_error.c_str());
+            return;
+        }
+        s_playback_error.clear();
+        const trajectory::Reader& reader = Playback::reader();
+        const auto frames = static_cast<int>(std::min<std::uint64_t>(reader.frame_count(), INT32_MAX));
+        if (ImGui::Button(Playback::playing() ? "Pause##playback" : "Play##playback")) {
+            if (!Playback::playing() && Playback::frame() + 1 >= reader.frame_count()) Playback::seek(0);
+            Playback::set_playing(!Playback::playing());
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Close##playback")) {
+            Playback::close();
+            return;
+        }
+        ImGui::SameLine();
+        ImGui::TextWrapped("%s", reader.path().filename().string().c_str());
+        int frame = static_cast<int>(Playback::frame());
+        if (ImGui::SliderInt("Frame", &frame, 0, std::max(0, frames - 1))) {
+            Playback::set_playing(false);
+            Playback::seek(static_cast<std::uint64_t>(frame));
+        }
+        ImGui::SliderFloat("Frames / s", &Playback::speed(), -nbody::constants::playback_fps_max,
+                           nbody::constants::playback_fps_max, "%.1f");
+        const RenderSnapshot& snap = Playback::snapshot();
+        ImGui::Text("Step %llu  t = %.3e s  %zu bodies", static_cast<unsigned long long>(snap.step), snap.sim_time,
+                    snap.size());
+        ImGui::Text("%d frames in %zu chunks, %.1f MiB", frames, reader.chunks().size(),
+                    static_cast<double>(reader.file_size()) / (1024.0 * 1024.0));
+    }
+
     static void draw_physics_panel(const flecs::world& w, Config& cfg) {
         ImGui::SetNextWindowPos(ImVec2(12, 140), ImGuiCond_FirstUseEver);
         ImGui::SetNextWindowSize(ImVec2(360, 0), ImGuiCond_FirstUseEver);
@@ -130,7 +320,21 @@ private:
                            nbody::constants::softening_max, "%.2e");
         ImGui::SliderFloat("Velocity Cap", &cfg.max_speed, nbody::constants::velocity_cap_min,
                            nbody::constants::velocity_cap_max, "%.0f");
-        if (ImGui::Button("Zero Net Momentum (Z)")) Physics::zero_net_momentum(w);
+        if (ImGui::Button("Zero Net Momentum (Z)")) Simulation::submit(w, Physics::zero_net_momentum);
+        ImGui::SliderInt("BH Threshold", &cfg.bh_threshold, 0, nbody::constants::bh_threshold_max);
+        ImGui::SameLine();
+        if (Calibration::running()) {
+            ImGui::TextDisabled("Calibrating...");
+        } else if (ImGui::Button("Calibrate")) {
+            Calibration::start(w, true);
+        }
+        if (const auto* cal = w.get<Calibration::Status>(); cal && cal->done && !Calibration::running()) {
+            if (cal->from_cache) {
+                ImGui::TextDisabled("Crossover %d bodies (cached for this machine)", cal->threshold);
+            } else {
+                ImGui::TextDisabled("Crossover %d bodies (measured in %.2f s)", cal->threshold, cal->seconds);
+            }
+        }
         ImGui::End();
     }
 
@@ -146,6 +350,44 @@ private:
         ImGui::SliderInt("Trail Length", &cfg.trail_max, 0, nbody::constants::trail_length_max);
         ImGui::SliderFloat("Radius Scale", &cfg.radius_scale, nbody::constants::radius_scale_min,
                            nbody::constants::radius_scale_max, "%.2f", ImGuiSliderFlags_Logarithmic);
+        ImGui::Checkbox("Sub-pixel LOD", &cfg.body_lod);
+        if (cfg.body_lod) {
+            ImGui::SameLine();
+            ImGui::TextDisabled("(above %d bodies)", cfg.lod_min_bodies);
+            ImGui::SliderFloat("Splat Size (px)", &cfg.lod_splat_px, 1.0f, nbody::constants::lod_splat_px_max, "%.1f");
+        }
+        const auto& renderStats = nbody::systems::WorldRenderer::stats();
+        if (AllocationCounter::enabled()) {
+            ImGui::TextDisabled("Render allocations last frame: %llu (%llu bytes)",
+                                static_cast<unsigned long long>(renderStats.allocations),
+                                static_cast<unsigned long long>(renderStats.allocated_bytes));
+        } else {
+            ImGui::TextDisabled("Render allocations: not counted (see Profiler)");
+        }
+        ImGui::Checkbox("Aggregate Tree Cells", &cfg.tree_aggregate);
+        if (cfg.tree_aggregate) {
+            ImGui::SameLine();
+            ImGui::TextDisabled("(when Barnes-Hut is active)");
+            ImGui::SliderFloat("Aggregate Below (px)", &cfg.aggregate_cell_px, 1.0f,
+                               nbody::constants::aggregate_cell_px_max, "%.1f");
+        }
+        ImGui::Separator();
+        ImGui::Text("Render Mode");
+        ImGui::RadioButton("Auto", &cfg.render_mode, 0);
+        ImGui::SameLine();
+        ImGui::RadioButton("Bodies", &cfg.render_mode, 1);
+        ImGui::SameLine();
+        ImGui::RadioButton("Density", &cfg.render_mode, 2);
+        if (cfg.render_mode == 0) {
+            ImGui::InputInt("Density Above N Bodies", &cfg.density_auto_bodies);
+            cfg.density_auto_bodies = std::max(1, cfg.density_auto_bodies);
+        }
+        if (cfg.render_mode != 1) {
+            ImGui::Checkbox("Weight by Mass", &cfg.density_by_mass);
+            ImGui::SliderInt("Cell Size (px)", &cfg.density_downsample, 1, nbody::constants::density_downsample_max);
+            ImGui::SliderFloat("Exposure", &cfg.density_exposure, nbody::constants::density_exposure_min,
+                               nbody::constants::density_exposure_max, "%.0f", ImGuiSliderFlags_Logarithmic);
+        }
         ImGui::End();
     }
 
@@ -171,17 +413,23 @@ private:
         ImGui::Checkbox("Shift+Click Adds Body", &cfg->enable_shift_click_add);
         if (ImGui::Button("Add Body At Mouse")) {
             const raylib::Vector2 mouseWorld = GetScreenToWorld2D(GetMousePosition(), cam);
-            w.entity()
-                .set<Position>({dvec2(mouseWorld)})
-                .set<Velocity>({dvec2(cfg->add_spawn_velocity)})
-                .set<Acceleration>({DVec2{0.0, 0.0}})
-                .set<PrevAcceleration>({DVec2{0.0, 0.0}})
-                .set<Mass>({std::max(nbody::constants::spawn_mass_min, cfg->add_spawn_mass)})
-                .set<Pinned>({cfg->add_spawn_pinned})
-                .set<Tint>({random_nice_color()})
-                .set<Trail>({{}})
-                .add<Selectable>()
-                .set<Draggable>({true, cfg->add_drag_vel_scale});
+            Simulation::submit(w, [pos = dvec2(mouseWorld), vel = dvec2(cfg->add_spawn_velocity),
+                                   mass = std::max(nbody::constants::spawn_mass_min, cfg->add_spawn_mass),
+                                   pinned = cfg->add_spawn_pinned, tint = random_nice_color(),
+                                   dragScale = cfg->add_drag_vel_scale](const flecs::world& sw) {
+                sw.entity()
+                    .set<Position>({pos})
+                    .set<PrevPosition>({pos})
+                    .set<Velocity>({vel})
+                    .set<Acceleration>({DVec2{0.0, 0.0}})
+                    .set<PrevAcceleration>({DVec2{0.0, 0.0}})
+                    .set<Mass>({mass})
+                    .set<Pinned>({pinned})
+                    .set<Tint>({tint})
+                    .set<Trail>({})
+                    .add<Selectable>()
+                    .set<Draggable>({true, dragScale});
+            });
         }
         ImGui::SliderFloat("Right-Drag Sensitivity", &cfg->add_drag_vel_scale, nbody::constants::drag_vel_scale_min,
                            nbody::constants::drag_vel_scale_max, "%.3f", ImGuiSliderFlags_Logarithmic);
@@ -210,8 +458,10 @@ private:
                 if (ImGui::Button("Zero Velocity")) vel->value = DVec2{0.0, 0.0};
                 ImGui::SameLine();
                 if (ImGui::Button("Remove Body")) {
-                    selected.destruct();
                     Interaction::select(w, flecs::entity::null());
+                    Simulation::submit(w, [selected](const flecs::world&) {
+                        if (selected.is_alive()) selected.destruct();
+                    });
                 }
                 ImGui::SameLine();
                 if (ImGui::Button("Focus Camera")) {
@@ -231,7 +481,8 @@ private:
 
         const float footer_h = ImGui::GetFrameHeightWithSpacing();
         if (ImGui::BeginChild("##BodyList", ImVec2(0, -footer_h), true)) {
-            std::vector<flecs::entity> entities;
+            static std::vector<flecs::entity> entities;  // reused so the list does not allocate every frame
+            entities.clear();
             w.each([&](const flecs::entity e, const Position&, const Mass&, const Tint&, const Selectable&) {
                 entities.push_back(e);
             });
@@ -252,7 +503,9 @@ private:
                                           t->value.b / static_cast<float>(nbody::constants::random_color_max), 1.0f),
                                    0, ImVec2(16, 16));
                 ImGui::SameLine();
-                if (ImGui::Selectable(("Entity " + std::to_string(e.id())).c_str(), isSel)) pendingSelection = e;
+                std::array<char, 32> label{};
+                std::snprintf(label.data(), label.size(), "Entity %llu", static_cast<unsigned long long>(e.id()));
+                if (ImGui::Selectable(label.data(), isSel)) pendingSelection = e;
                 ImGui::SameLine();
                 ImGui::Text("pos(%.2e, %.2e) m=%.2e", p->value.x, p->value.y, m->value);
                 ImGui::PopID();
@@ -272,17 +525,21 @@ private:
                     auto t = *e.get<Tint>();
                     auto pin = *e.get<Pinned>();
                     p.value.x += static_cast<double>(nbody::constants::duplicate_offset_x);
-                    w.entity()
-                        .set(p)
-                        .set(v)
-                        .set(Acceleration{DVec2{0.0, 0.0}})
-                        .set(PrevAcceleration{DVec2{0.0, 0.0}})
-                        .set(m)
-                        .set(pin)
-                        .set(t)
-                        .set(Trail{{}})
-                        .add<Selectable>()
-                        .set<Draggable>({true, cfg ? cfg->add_drag_vel_scale : nbody::constants::drag_vel_scale});
+                    const float dragScale = cfg ? cfg->add_drag_vel_scale : nbody::constants::drag_vel_scale;
+                    Simulation::submit(w, [p, v, m, pin, t, dragScale](const flecs::world& sw) {
+                        sw.entity()
+                            .set(p)
+                            .set(PrevPosition{p.value})
+                            .set(v)
+                            .set(Acceleration{DVec2{0.0, 0.0}})
+                            .set(PrevAcceleration{DVec2{0.0, 0.0}})
+                            .set(m)
+                            .set(pin)
+                            .set(t)
+                            .set(Trail{})
+                            .add<Selectable>()
+                            .set<Draggable>({true, dragScale});
+                    });
                 }
             }
         }
@@ -313,6 +570,147 @@ private:
         ImGui::End();
     }
 
+    // Where each frame's time went: stacked per-stage timeline (oldest left) and min/avg/p99 over the window.
+    // Simulation stages run on their own thread, so a frame's stack can exceed its wall time.
+    static void draw_profiler_panel() {
+        using Stage = Profiler::Stage;
+        static int window = constants::default_profiler_window;
+        static const std::array<ImVec4, Profiler::kStages> colors = {
+            ImVec4(0.90f, 0.35f, 0.30f, 1.0f),  // Collision
+            ImVec4(0.95f, 0.70f, 0.25f, 1.0f),  // Gravity build
+            ImVec4(0.95f, 0.90f, 0.35f, 1.0f),  // Gravity walk
+            ImVec4(0.40f, 0.80f, 0.40f, 1.0f),  // Integration
+            ImVec4(0.35f, 0.75f, 0.85f, 1.0f),  // Trails
+            ImVec4(0.55f, 0.50f, 0.90f, 1.0f),  // Diagnostics
+            ImVec4(0.85f, 0.50f, 0.80f, 1.0f),  // Rendering
+            ImVec4(0.70f, 0.70f, 0.70f, 1.0f),  // UI
+        };
+
+        ImGui::SetNextWindowPos(ImVec2(800, 330), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowSize(ImVec2(460, 0), ImGuiCond_FirstUseEver);
+        ImGui::Begin("Profiler");
+        ImGui::SliderInt("Frames", &window, 10, static_cast<int>(Profiler::kHistory));
+        bool countAllocations = AllocationCounter::enabled();
+        if (ImGui::Checkbox("Count allocations", &countAllocations)) AllocationCounter::set_enabled(countAllocations);
+        const Profiler::Summary sum = Profiler::summarize(static_cast<std::size_t>(window));
+        const std::size_t frames = sum.frames;
+
+        // Scale to the tallest stack (or frame) in view
+        float peak = 1.0f;
+        for (std::size_t age = 0; age < frames; ++age) {
+            const Profiler::Frame& f = Profiler::frame(age);
+            float stack = 0.0f;
+            for (const float ms : f.stage_ms) stack += ms;
+            peak = std::max({peak, stack, f.frame_ms});
+        }
+
+        const ImVec2 origin = ImGui::GetCursorScreenPos();
+        const ImVec2 size(std::max(1.0f, ImGui::GetContentRegionAvail().x), constants::profiler_timeline_height);
+        ImDrawList* dl = ImGui::GetWindowDrawList();
+        dl->AddRectFilled(origin, ImVec2(origin.x + size.x, origin.y + size.y), IM_COL32(20, 20, 24, 255));
+        const float barW = size.x / static_cast<float>(std::max(1, window));
+        const float pxPerMs = size.y / peak;
+        const float bottom = origin.y + size.y;
+        for (std::size_t age = 0; age < frames; ++age) {
+            const Profiler::Frame& f = Profiler::frame(age);
+            const float x1 = origin.x + size.x - static_cast<float>(age) * barW;
+            const float x0 = x1 - barW;
+            float y = bottom;
+            for (std::size_t s = 0; s < Profiler::kStages; ++s) {
+                const float h = f.stage_ms[s] * pxPerMs;
+                if (h <= 0.0f) continue;
+                dl->AddRectFilled(ImVec2(x0, y - h), ImVec2(x1, y), ImGui::ColorConvertFloat4ToU32(colors[s]));
+                y -= h;
+            }
+            const float fy = bottom - f.frame_ms * pxPerMs;
+            dl->AddLine(ImVec2(x0, fy), ImVec2(x1, fy), IM_COL32(255, 255, 255, 200));
+        }
+        ImGui::Dummy(size);
+        if (ImGui::IsItemHovered() && frames > 0) {
+            const float fromRight = origin.x + size.x - ImGui::GetIO().MousePos.x;
+            if (const auto age = static_cast<std::size_t>(std::max(0.0f, fromRight / barW)); age < frames) {
+                const Profiler::Frame& f = Profiler::frame(age);
+                ImGui::BeginTooltip();
+                ImGui::Text("%zu frames ago: %.2f ms", age, f.frame_ms);
+                for (std::size_t s = 0; s < Profiler::kStages; ++s) {
+                    ImGui::TextColored(colors[s], "%s: %.3f ms", Profiler::label(static_cast<Stage>(s)),
+                                       f.stage_ms[s]);
+                }
+                ImGui::EndTooltip();
+            }
+        }
+        ImGui::Text("Scale: %.2f ms  (white: frame time)", peak);
+
+        // Allocation columns are per-frame means; the Frame row counts every thread, inside a stage or not.
+        const int columns = countAllocations ? 6 : 4;
+        if (ImGui::BeginTable("profiler_stats", columns, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+            ImGui::TableSetupColumn("Stage");
+            ImGui::TableSetupColumn("min ms");
+            ImGui::TableSetupColumn("avg ms");
+            ImGui::TableSetupColumn("p99 ms");
+            if (countAllocations) {
+                ImGui::TableSetupColumn("allocs");
+                ImGui::TableSetupColumn("KiB");
+            }
+            ImGui::TableHeadersRow();
+            const auto row = [&](const char* name, const ImVec4& color, const Profiler::Stats& st, const float allocs,
+                                 const float bytes) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextColored(color, "%s", name);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", st.min);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", st.avg);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", st.p99);
+                if (!countAllocations) return;
+                ImGui::TableNextColumn();
+                if (allocs > 0.0f) {
+                    ImGui::TextColored(ImVec4(1, 0.6f, 0.3f, 1), "%.1f", allocs);
+                } else {
+                    ImGui::TextDisabled("0");
+                }
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", bytes / 1024.0f);
+            };
+            for (std::size_t s = 0; s < Profiler::kStages; ++s) {
+                row(Profiler::label(static_cast<Stage>(s)), colors[s], sum.stages[s], sum.allocs[s], sum.bytes[s]);
+            }
+            row("Frame", ImVec4(1, 1, 1, 1), sum.frame, sum.frame_allocs, sum.frame_bytes);
+            ImGui::EndTable();
+        }
+        draw_trace_section();
+        ImGui::End();
+    }
+
+    static void draw_trace_section() {
+        if (!ImGui::CollapsingHeader("Trace Capture")) return;
+        static int frames = constants::default_trace_frames;
+        if (TraceCapture::active()) {
+            ImGui::Text("Capturing... %zu frames left", Profiler::trace_frames_left());
+            return;
+        }
+        ImGui::SliderInt("Frames##trace", &frames, 1, constants::trace_frames_max, "%d", ImGuiSliderFlags_Logarithmic);
+        if (ImGui::Button("Capture Chrome Trace")) TraceCapture::start(frames);
+        if (!TraceCapture::last_error().empty()) {
+            ImGui::TextColored(ImVec4(1, 0.4f, 0.3f, 1), "%s", TraceCapture::last_error().c_str());
+        } else if (!TraceCapture::last_path().empty()) {
+            ImGui::TextWrapped("Saved: %s", TraceCapture::last_path().c_str());
+        }
+    }
+
+    // Write a freshly captured scenario to disk; on success it becomes file-backed and drops its in-memory bodies.
+    static void persist_scenario(Scenario& s, const std::filesystem::path& path) {
+        if (!ScenarioFile::save(path, s)) {
+            TraceLog(LOG_WARNING, "Could not save scenario to %s; keeping it in memory only", path.string().c_str());
+            return;
+        }
+        s.file = path.string();
+        s.body_count = s.bodies.size();
+        s.bodies = {};
+    }
+
     static void draw_scenarios_panel(const flecs::world& w) {
         ImGui::SetNextWindowPos(ImVec2(800, 12), ImGuiCond_FirstUseEver);
         ImGui::SetNextWindowSize(ImVec2(460, 300), ImGuiCond_FirstUseEver);
@@ -323,6 +721,7 @@ private:
         if (!store) {
             w.set<ScenarioStore>({});
             store = w.get_mut<ScenarioStore>();
+            ScenarioFile::load_library(*store);
         }
 
         static char nameBuf[96] = {0};
@@ -351,13 +750,15 @@ private:
                 if (comma == std::string::npos) break;
                 start = comma + 1;
             }
+            persist_scenario(s, ScenarioFile::unique_path(s.name));
             store->items.push_back(std::move(s));
             store->selected = static_cast<int>(store->items.size()) - 1;
         }
         ImGui::SameLine();
         const bool canSel = (store->selected >= 0 && store->selected < (int)store->items.size());
+        const std::size_t sel = canSel ? static_cast<std::size_t>(store->selected) : 0;
         if (ImGui::Button("Overwrite Selected") && canSel) {
-            const std::string name = (nameBuf[0] != '\0') ? std::string(nameBuf) : store->items[store->selected].name;
+            const std::string name = (nameBuf[0] != '\0') ? std::string(nameBuf) : store->items[sel].name;
             const std::string desc = std::string(descBuf);
             Scenario s = snapshot_from_world(w, name, desc);
             // use current tagsBuf
@@ -373,18 +774,20 @@ private:
                 if (comma == std::string::npos) break;
                 start = comma + 1;
             }
-            store->items[store->selected] = std::move(s);
+            const std::string& oldFile = store->items[sel].file;
+            persist_scenario(s, oldFile.empty() ? ScenarioFile::unique_path(s.name) : std::filesystem::path(oldFile));
+            store->items[sel] = std::move(s);
         }
 
         ImGui::Separator();
         static char filterBuf[96] = {0};
         ImGui::Text("Saved Scenarios (%zu)", store->items.size());
         ImGui::InputTextWithHint("##filter", "Filter by name or tag", filterBuf, sizeof(filterBuf));
-        std::string filterStr(filterBuf);
+        const std::string_view filterStr(filterBuf);
         ImGui::BeginChild("##ScenarioList", ImVec2(0, 140), true);
         for (int i = 0; i < static_cast<int>(store->items.size()); ++i) {
             const bool selected = (store->selected == i);
-            const auto& s = store->items[i];
+            const auto& s = store->items[static_cast<std::size_t>(i)];
             // If filter present, skip items that do not match name or any tag
             if (!filterStr.empty()) {
                 bool match = s.name.find(filterStr) != std::string::npos;
@@ -398,7 +801,10 @@ private:
                 }
                 if (!match) continue;
             }
-            if (ImGui::Selectable((s.name + "##" + std::to_string(i)).c_str(), selected)) {
+            ImGui::PushID(i);
+            const bool clicked = ImGui::Selectable(s.name.c_str(), selected);
+            ImGui::PopID();
+            if (clicked) {
                 store->selected = i;
                 // Prime inputs with selected scenario's metadata
                 strncpy(nameBuf, s.name.c_str(), sizeof(nameBuf));
@@ -426,10 +832,11 @@ private:
                     }
                     ImGui::NewLine();
                 }
+                if (!s.file.empty()) ImGui::TextDisabled("%s", s.file.c_str());
                 ImGui::Text(
                     "Bodies: %zu  G: %.2e  Soft: %.2e  dtScale: %.2e  Integrator: %d  RadScale: %.2f  Trails:%s",
-                    s.bodies.size(), s.g, s.softening, s.time_scale, s.integrator, s.radius_scale,
-                    s.draw_trails ? "on" : "off");
+                    s.bodies.empty() ? s.body_count : s.bodies.size(), s.g, s.softening, s.time_scale, s.integrator,
+                    s.radius_scale, s.draw_trails ? "on" : "off");
             }
         }
         ImGui::EndChild();
@@ -437,29 +844,107 @@ private:
         const bool canAct = canSel;
         ImGui::Checkbox("Apply Config on Load", &applyConfigOnLoad);
         if (ImGui::Button("Load Selected") && canAct) {
-            if (applyConfigOnLoad) {
-                apply_scenario_to_world(w, store->items[store->selected]);
-            } else {
-                apply_scenario_bodies_only(w, store->items[store->selected]);
-            }
-            // Reset camera for a clean view
-            Camera::reset_view(w);
+            Interaction::select(w, flecs::entity::null());
+            Simulation::submit(w, [s = store->items[sel], applyConfig = applyConfigOnLoad](
+                                      const flecs::world& sw) {
+                if (!s.file.empty()) {
+                    if (!ScenarioFile::load_into(sw, s.file, applyConfig))
+                        TraceLog(LOG_WARNING, "Could not load scenario file %s", s.file.c_str());
+                } else if (applyConfig) {
+                    apply_scenario_to_world(sw, s);
+                } else {
+                    apply_scenario_bodies_only(sw, s);
+                }
+                // Reset camera for a clean view
+                Camera::reset_view(sw);
+            });
         }
         ImGui::SameLine();
         if (ImGui::Button("Delete Selected") && canAct) {
+            if (const auto& file = store->items[sel].file; !file.empty()) {
+                std::error_code ec;
+                std::filesystem::remove(file, ec);
+            }
             store->items.erase(store->items.begin() + store->selected);
             store->selected = -1;
         }
 
+        draw_generate_section(w);
+        draw_import_section(w);
         ImGui::End();
     }
 
+    static void draw_generate_section(const flecs::world& w) {
+        if (!ImGui::CollapsingHeader("Generate")) return;
+        static Generators::Params params;
+        static int bodies = nbody::constants::default_generator_bodies;
+        if (ImGui::BeginCombo("Model", Generators::label(params.kind))) {
+            for (const Generators::Kind kind : Generators::kKinds) {
+                if (ImGui::Selectable(Generators::label(kind), kind == params.kind)) params.kind = kind;
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::SliderInt("Bodies", &bodies, 1, nbody::constants::generator_bodies_max, "%d",
+                         ImGuiSliderFlags_Logarithmic);
+        ImGui::InputScalar("Seed", ImGuiDataType_U64, &params.seed);
+        ImGui::Checkbox("Set softening", &params.set_softening);
+        if (ImGui::Button("Generate")) {
+            params.count = static_cast<std::size_t>(std::max(1, bodies));
+            Interaction::select(w, flecs::entity::null());
+            Simulation::submit(w, [p = params](const flecs::world& sw) {
+                Generators::apply(sw, p);
+                Camera::reset_view(sw);
+            });
+        }
+    }
+
+    // Import: parsing runs on a worker so the UI stays responsive; the result is applied on the simulation thread
+    static inline std::future<Importer::Result> s_import;
+    static inline std::string s_import_status;
+
+    static void draw_import_section(const flecs::world& w) {
+        if (!ImGui::CollapsingHeader("Import Bodies")) return;
+        static char pathBuf[512] = {0};
+        static Importer::BinaryLayout layout;
+        ImGui::InputTextWithHint("File", "bodies.csv or bodies.bin", pathBuf, sizeof(pathBuf));
+        if (!Importer::is_csv(pathBuf)) {
+            ImGui::Checkbox("Radius column", &layout.radius);
+            ImGui::SameLine();
+            ImGui::Checkbox("RGBA column", &layout.color);
+        }
+        const bool busy = s_import.valid();
+        if (busy && s_import.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            auto result = std::make_shared<const Importer::Result>(s_import.get());
+            if (result->error.empty()) {
+                s_import_status = "Imported " + std::to_string(result->size()) + " bodies";
+                Interaction::select(w, flecs::entity::null());
+                Simulation::submit(w, [result](const flecs::world& sw) {
+                    Importer::apply(sw, *result);
+                    Camera::reset_view(sw);
+                });
+            } else {
+                s_import_status = result->error;
+            }
+        }
+        if (busy) {
+            ImGui::TextDisabled("Importing...");
+        } else if (ImGui::Button("Import") && pathBuf[0] != '\0') {
+            s_import = std::async(std::launch::async, [path = std::filesystem::path(pathBuf), l = layout] {
+                return Importer::read(path, l);
+            });
+            s_import_status.clear();
+        }
+        if (!s_import_status.empty()) ImGui::TextWrapped("%s", s_import_status.c_str());
+    }
+
     // No extra bridge helpers needed when including Interaction.hpp
     static void perform_reset_scenario(const flecs::world& w, Config& cfg) {
-        Physics::reset_scenario(w);
-        Physics::zero_net_momentum(w);
         Interaction::select(w, flecs::entity::null());
         cfg.paused = false;
+        Simulation::submit(w, [](const flecs::world& sw) {
+            Physics::reset_scenario(sw);
+            Physics::zero_net_momentum(sw);
+        });
     }
 
     static void perform_reset_all(const flecs::world& w) {
@@ -471,19 +956,20 @@ private:
         w.set<Config>({});
         auto* cfg = w.get_mut<Config>();
         if (cfg) cfg->paused = false;
-
-        // Rebuild bodies
-        Physics::reset_scenario(w);
-        Physics::zero_net_momentum(w);
-
-        // Reset camera view
-        if (auto* cam = Camera::get(w)) {
-            Camera::init(*cam);
-            if (const auto* c = w.get<Config>())
-                cam->zoom = std::clamp(static_cast<float>(c->meter_to_pixel), nbody::constants::min_zoom,
-                                       nbody::constants::max_zoom);
-        }
-        Camera::center_on_center_of_mass(w);
+        if (cfg && cfg->calibrate_bh_on_startup) Calibration::start(w, false);
+
+        // Rebuild bodies and reset camera view once the new bodies exist
+        Simulation::submit(w, [](const flecs::world& sw) {
+            Physics::reset_scenario(sw);
+            Physics::zero_net_momentum(sw);
+            if (auto* cam = Camera::get(sw)) {
+                Camera::init(*cam);
+                if (const auto* c = sw.get<Config>())
+                    cam->zoom = std::clamp(static_cast<float>(c->meter_to_pixel), nbody::constants::min_zoom,
+                                           nbody::constants::max_zoom);
+            }
+            Camera::center_on_center_of_mass(sw);
+        });
 
         // Reset UI inputs next frame
         s_pending_reset_inputs = true;
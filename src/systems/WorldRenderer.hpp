@@ -2,102 +2,399 @@
 
 #include <algorithm>
 #include <cmath>
-#include <flecs.h>
-#include <numbers>
+#include <cstdint>
 #include <raylib-cpp.hpp>
 #include <raymath.h>
+#include <rlgl.h>
 #include <vector>
 
-#include "../components/Components.hpp"
+#include "../core/AllocationCounter.hpp"
 #include "../core/Config.hpp"
 #include "../core/Constants.hpp"
-#include "Interaction.hpp"
+#include "../core/Math.hpp"
+#include "../core/RenderSnapshot.hpp"
+#include "DensityRenderer.hpp"
 
 namespace nbody::systems {
 
 class WorldRenderer {
 public:
-    static void render_scene(const flecs::world& w, const Config& cfg, raylib::Camera2D& cam) {
+    // Axis-aligned world-space rectangle currently covered by the camera.
+    struct ViewRect {
+        float min_x = 0.0F;
+        float min_y = 0.0F;
+        float max_x = 0.0F;
+        float max_y = 0.0F;
+
+        [[nodiscard]] auto overlaps(const float x0, const float y0, const float x1, const float y1) const -> bool {
+            return x1 >= min_x && x0 <= max_x && y1 >= min_y && y0 <= max_y;
+        }
+        [[nodiscard]] auto overlaps_circle(const float x, const float y, const float r) const -> bool {
+            return overlaps(x - r, y - r, x + r, y + r);
+        }
+    };
+
+    static auto view_rect(const raylib::Camera2D& cam) -> ViewRect {
+        const raylib::Vector2 tl = GetScreenToWorld2D(::Vector2{0, 0}, cam);
+        const raylib::Vector2 br = GetScreenToWorld2D(
+            ::Vector2{static_cast<float>(GetScreenWidth()), static_cast<float>(GetScreenHeight())}, cam);
+        return ViewRect{std::min(tl.x, br.x), std::min(tl.y, br.y), std::max(tl.x, br.x), std::max(tl.y, br.y)};
+    }
+
+    struct Stats {
+        std::uint64_t allocations = 0;  // heap allocations made by the last render_scene (0 in steady state)
+        std::uint64_t allocated_bytes = 0;
+    };
+
+    [[nodiscard]] static auto stats() -> const Stats& { return stats_storage(); }
+
+    // alpha blends each body between its previous and current physics state (see RenderSnapshot).
+    // All scratch (grid lines, tree stack, density buffers) persists across frames, so steady-state frames do not
+    // allocate; stats() reports the last frame's count as a check.
+    static void render_scene(const RenderSnapshot& snap, const double alpha, raylib::Camera2D& cam) {
+        const AllocationCounter::Scope allocations;
+        render_scene_impl(snap, alpha, cam);
+        stats_storage() = Stats{allocations.count(), allocations.bytes()};
+    }
+
+    // Release GPU resources; call before CloseWindow().
+    static void shutdown() {
+        if (s_circle_tex.id != 0) UnloadTexture(s_circle_tex);
+        s_circle_tex = Texture2D{};
+        DensityRenderer::shutdown();
+    }
+
+private:
+    static inline Texture2D s_circle_tex{};
+    static auto stats_storage() -> Stats& {
+        static Stats stats;
+        return stats;
+    }
+
+    static void render_scene_impl(const RenderSnapshot& snap, const double alpha, raylib::Camera2D& cam) {
+        const Config& cfg = snap.cfg;
+        const ViewRect view = view_rect(cam);
         cam.BeginMode();
-        draw_world_grid(cam, nbody::constants::grid_spacing);
-
-        if (cfg.draw_trails) {
-            w.each([&](const Trail& t, const Tint& tint) {
-                for (size_t k = 1; k < t.points.size(); ++k) {
-                    Color c = tint.value;
-                    const double denom = std::max(1.0, static_cast<double>(t.points.size()));
-                    c.a = static_cast<unsigned char>(std::clamp(
-                        nbody::constants::trail_alpha_min +
-                            static_cast<int>(nbody::constants::trail_alpha_range * static_cast<double>(k) / denom),
-                        nbody::constants::trail_alpha_min, nbody::constants::trail_alpha_max));
-                    DrawLineV(t.points[k - 1], t.points[k], c);
-                }
-            });
-        }
-
-        std::vector<flecs::entity> entities;
-        w.each([&](const flecs::entity e, const Position&, const Velocity&, const Acceleration&, const Mass&,
-                   const Tint&) { entities.push_back(e); });
-        std::sort(entities.begin(), entities.end(), [](flecs::entity a, flecs::entity b) {
-            const auto* ma = a.get<Mass>();
-            const auto* mb = b.get<Mass>();
-            const float av = ma ? ma->value : 0.0f;
-            const float bv = mb ? mb->value : 0.0f;
-            return av > bv;
-        });
-        for (auto e : entities) {
-            const auto* p = e.get<Position>();
-            const auto* a = e.get<Acceleration>();
-            const auto* m = e.get<Mass>();
-            const auto* tint = e.get<Tint>();
-            if (!p || !a || !m || !tint) continue;
-            double rMeters = 0.0;
-            if (const auto* rad = e.get<Radius>()) {
-                rMeters = rad->value;
+        draw_world_grid(view, cam.zoom);
+
+        // Above the density threshold individual bodies, trails and vectors are neither readable nor affordable.
+        if (DensityRenderer::active(snap)) {
+            EndMode2D();
+            DensityRenderer::draw(snap, alpha, cam);
+            return;
+        }
+
+        if (cfg.draw_trails) draw_trails(snap, view);
+
+        const float minRadiusWorld = nbody::constants::min_body_radius / cam.zoom;
+        if (!cfg.tree_aggregate || snap.tree_cells.empty() || !draw_tree(snap, alpha, view, cam.zoom, minRadiusWorld)) {
+            draw_bodies(snap, alpha, view, cam.zoom, minRadiusWorld);
+        }
+        // Velocity vectors intentionally not drawn.
+        if (cfg.draw_acceleration) {
+            const float accScale = nbody::constants::acc_vector_scale / cam.zoom;
+            for (const std::uint32_t i : snap.draw_order) {
+                const raylib::Vector2 p = fvec2(snap.position_at(i, alpha));
+                if (!view.overlaps_circle(p.x, p.y, minRadiusWorld)) continue;
+                const DVec2& a = snap.accelerations[i];
+                const raylib::Vector2 tip = p + raylib::Vector2{static_cast<float>(a.x * accScale), static_cast<float>(a.y * accScale)};
+                DrawLineEx(p, tip, nbody::constants::acc_line_width / cam.zoom, ORANGE);
+            }
+        }
+
+        EndMode2D();
+    }
+
+    // One glyph of the tree path: an aggregated cell or a single body.
+    struct TreeItem {
+        float x, y, r;
+        float mass;
+        Color tint;
+        bool splat;
+    };
+    static inline std::vector<std::uint32_t> s_tree_stack;
+    static inline std::vector<TreeItem> s_tree_items;
+
+    struct GridLine {
+        float x0, y0, x1, y1;
+        Color color;
+    };
+    struct GridCache {
+        ViewRect view{};
+        float zoom = 0.0F;
+        std::vector<GridLine> lines;
+    };
+    // Function-local so the nested types are complete where the cache is initialised.
+    static auto grid_cache() -> GridCache& {
+        static GridCache cache;
+        return cache;
+    }
+
+    // Bodies are textured quads sampling one anti-aliased circle texture, submitted through the rlgl batch:
+    // 4 vertices per body instead of a triangle fan, one draw call per batch flush. Plain GL 1.1-level
+    // features only, so it also runs on Mesa software GL.
+    // Off-screen bodies are culled. In large scenes, bodies whose true size is far below a pixel are drawn
+    // as small untextured splats instead of being inflated to min_body_radius.
+    static void draw_bodies(const RenderSnapshot& snap, const double alpha, const ViewRect& view, const float zoom,
+                            const float minRadiusWorld) {
+        const Config& cfg = snap.cfg;
+        const float radiusScale = cfg.radius_scale;
+        const bool lod = cfg.body_lod && static_cast<int>(snap.size()) >= cfg.lod_min_bodies;
+        const float subpixelWorld = cfg.lod_subpixel_px / zoom;
+        const float splatHalf = 0.5F * cfg.lod_splat_px / zoom;
+        const auto isSplat = [&](const std::uint32_t i) { return lod && radiusScale * snap.radii[i] < subpixelWorld; };
+
+        if (!ensure_circle_texture()) {
+            for (const std::uint32_t i : snap.draw_order) {
+                const raylib::Vector2 p = fvec2(snap.position_at(i, alpha));
+                const float r = std::max(minRadiusWorld, radiusScale * snap.radii[i]);
+                if (view.overlaps_circle(p.x, p.y, r)) DrawCircleV(p, r, snap.tints[i]);
+            }
+            return;
+        }
+
+        // Pass 1: sub-pixel splats (default white texture); pass 2: circles.
+        for (const bool splats : {true, false}) {
+            if (splats && !lod) continue;
+            rlSetTexture(splats ? rlGetTextureIdDefault() : s_circle_tex.id);
+            QuadBatch batch;
+            for (const std::uint32_t i : snap.draw_order) {
+                if (isSplat(i) != splats) continue;
+                const DVec2 p = snap.position_at(i, alpha);
+                const auto x = static_cast<float>(p.x);
+                const auto y = static_cast<float>(p.y);
+                const float r = splats ? splatHalf : std::max(minRadiusWorld, radiusScale * snap.radii[i]);
+                if (view.overlaps_circle(x, y, r)) batch.add(x, y, r, snap.tints[i]);
+            }
+            batch.finish();
+        }
+        rlSetTexture(0);
+    }
+
+    // Zoomed-out path: walk the last Barnes-Hut tree, skipping off-screen subtrees, and draw every cell narrower
+    // than aggregate_cell_px as one glyph at its interpolated centre of mass (mass-weighted tint, radius from total
+    // mass). Larger cells are opened down to single bodies, so cost is O(visible cells) rather than O(N).
+    // Glyphs keep draw_bodies' conventions: descending mass order, sub-pixel splats, DrawCircleV without the
+    // texture. Returns false without drawing when no visible cell is small enough to aggregate (zoomed in), so the
+    // caller draws bodies as usual.
+    static bool draw_tree(const RenderSnapshot& snap, const double alpha, const ViewRect& view, const float zoom,
+                          const float minRadiusWorld) {
+        const Config& cfg = snap.cfg;
+        const auto& cells = snap.tree_cells;
+        const float radiusScale = cfg.radius_scale;
+        const float aggregateWorld = cfg.aggregate_cell_px / zoom;
+        const float margin = std::max(minRadiusWorld, radiusScale * snap.max_radius);
+        const bool lod = cfg.body_lod && static_cast<int>(snap.size()) >= cfg.lod_min_bodies;
+        const float subpixelWorld = cfg.lod_subpixel_px / zoom;
+        const float splatHalf = 0.5F * cfg.lod_splat_px / zoom;
+
+        bool aggregated = false;
+        s_tree_items.clear();
+        s_tree_stack.clear();
+        s_tree_stack.push_back(0);
+        while (!s_tree_stack.empty()) {
+            const std::uint32_t k = s_tree_stack.back();
+            s_tree_stack.pop_back();
+            const SpatialPartition::Cell& c = cells[k];
+            if (c.mass <= 0.0F) continue;
+            const float h = c.halfSize + margin;
+            if (!view.overlaps(c.center.x - h, c.center.y - h, c.center.x + h, c.center.y + h)) continue;
+            if (c.first_child == 0) {
+                if (c.body < 0) continue;
+                const auto i = static_cast<std::size_t>(c.body);
+                const raylib::Vector2 p = fvec2(snap.position_at(i, alpha));
+                const float trueRadius = radiusScale * snap.radii[i];
+                const bool splat = lod && trueRadius < subpixelWorld;
+                const float r = splat ? splatHalf : std::max(minRadiusWorld, trueRadius);
+                s_tree_items.push_back({p.x, p.y, r, snap.masses[i], snap.tints[i], splat});
+            } else if (2.0F * c.halfSize < aggregateWorld) {
+                const raylib::Vector2 p = fvec2(snap.cell_com_at(k, alpha));
+                const float r = std::max(minRadiusWorld, radiusScale * RenderSnapshot::radius_for_mass(c.mass));
+                s_tree_items.push_back({p.x, p.y, r, c.mass, snap.tree_tints[k], false});
+                aggregated = true;
             } else {
-                const double safeMass = std::max(1.0, static_cast<double>(m->value));
-                rMeters = std::cbrt((3.0 * safeMass) / (4.0 * std::numbers::pi * nbody::constants::body_density));
+                for (std::uint32_t q = 0; q < 4; ++q) s_tree_stack.push_back(c.first_child + q);
+            }
+        }
+        if (!aggregated) return false;
+
+        // Ties broken by position so equal masses keep a stable stacking order from frame to frame.
+        std::sort(s_tree_items.begin(), s_tree_items.end(), [](const TreeItem& a, const TreeItem& b) {
+            if (a.mass != b.mass) return a.mass > b.mass;
+            return a.x != b.x ? a.x < b.x : a.y < b.y;
+        });
+        if (!ensure_circle_texture()) {
+            for (const TreeItem& item : s_tree_items) {
+                if (view.overlaps_circle(item.x, item.y, item.r)) DrawCircleV({item.x, item.y}, item.r, item.tint);
             }
-            const float minRadiusWorld = nbody::constants::min_body_radius / cam.zoom;
-            const float r = std::max(minRadiusWorld, static_cast<float>(cfg.radius_scale) * static_cast<float>(rMeters));
-            DrawCircleV(fvec2(p->value), r, tint->value);
-            // Velocity vectors intentionally not drawn.
-            if (cfg.draw_acceleration) {
-                const float accScale = nbody::constants::acc_vector_scale / cam.zoom;
-                const raylib::Vector2 tip = fvec2(p->value) + raylib::Vector2{static_cast<float>(a->value.x * accScale), static_cast<float>(a->value.y * accScale)};
-                DrawLineEx(fvec2(p->value), tip, nbody::constants::acc_line_width / cam.zoom, ORANGE);
+            return true;
+        }
+        // Pass 1: sub-pixel splats (default white texture); pass 2: circles.
+        for (const bool splats : {true, false}) {
+            if (splats && !lod) continue;
+            rlSetTexture(splats ? rlGetTextureIdDefault() : s_circle_tex.id);
+            QuadBatch batch;
+            for (const TreeItem& item : s_tree_items) {
+                if (item.splat == splats && view.overlaps_circle(item.x, item.y, item.r)) {
+                    batch.add(item.x, item.y, item.r, item.tint);
+                }
             }
+            batch.finish();
         }
+        rlSetTexture(0);
+        return true;
+    }
 
-        EndMode2D();
+    // Circle quads into the rlgl batch, split into chunks of body_batch_quads; the caller binds the texture.
+    struct QuadBatch {
+        bool open = false;
+        std::size_t count = 0;
+
+        void add(const float x, const float y, const float r, const Color c) {
+            if (!open || count == constants::body_batch_quads) {
+                if (open) rlEnd();
+                rlCheckRenderBatchLimit(static_cast<int>(4 * constants::body_batch_quads));
+                rlBegin(RL_QUADS);
+                open = true;
+                count = 0;
+            }
+            ++count;
+            rlColor4ub(c.r, c.g, c.b, c.a);
+            rlTexCoord2f(0.0F, 0.0F);
+            rlVertex2f(x - r, y - r);
+            rlTexCoord2f(0.0F, 1.0F);
+            rlVertex2f(x - r, y + r);
+            rlTexCoord2f(1.0F, 1.0F);
+            rlVertex2f(x + r, y + r);
+            rlTexCoord2f(1.0F, 0.0F);
+            rlVertex2f(x + r, y - r);
+        }
+
+        void finish() {
+            if (open) rlEnd();
+            open = false;
+        }
+    };
+
+    // All trails go into one rlgl line batch, read straight from the ring buffer spans, with per-vertex alpha
+    // fading from trail_alpha_min at the oldest point to trail_alpha_max at the newest. The batch is only
+    // flushed when full, so a frame costs a few draw calls regardless of the number of trails.
+    static void draw_trails(const RenderSnapshot& snap, const ViewRect& view) {
+        rlSetTexture(0);
+        rlBegin(RL_LINES);
+        std::size_t inBatch = 0;
+        for (size_t i = 0; i < snap.size(); ++i) {
+            const auto spans = snap.trails.spans(snap.trail_slots[i]);
+            const size_t count = spans[0].size + spans[1].size;
+            if (count < 2) continue;
+            const Color c = snap.tints[i];
+            // Alpha grows linearly with the point index; keep it in fixed steps to stay out of double math.
+            const float alphaStep = nbody::constants::trail_alpha_range / static_cast<float>(count);
+            float alpha = static_cast<float>(nbody::constants::trail_alpha_min);
+            bool havePrev = false;
+            float px = 0.0F;
+            float py = 0.0F;
+            unsigned char pa = 0;
+            for (const auto& sp : spans) {
+                for (size_t k = 0; k < sp.size; ++k) {
+                    const float x = sp.x[k];
+                    const float y = sp.y[k];
+                    const auto a = static_cast<unsigned char>(
+                        std::min(alpha, static_cast<float>(nbody::constants::trail_alpha_max)));
+                    alpha += alphaStep;
+                    if (havePrev && view.overlaps(std::min(px, x), std::min(py, y), std::max(px, x), std::max(py, y))) {
+                        if (inBatch == constants::trail_batch_segments) {
+                            rlEnd();
+                            rlCheckRenderBatchLimit(static_cast<int>(2 * constants::trail_batch_segments));
+                            rlBegin(RL_LINES);
+                            inBatch = 0;
+                        }
+                        ++inBatch;
+                        rlColor4ub(c.r, c.g, c.b, pa);
+                        rlVertex2f(px, py);
+                        rlColor4ub(c.r, c.g, c.b, a);
+                        rlVertex2f(x, y);
+                    }
+                    havePrev = true;
+                    px = x;
+                    py = y;
+                    pa = a;
+                }
+            }
+        }
+        rlEnd();
     }
 
-private:
-    static void draw_world_grid(const raylib::Camera2D& cam, const float spacing) {
-        const raylib::Vector2 tl = GetScreenToWorld2D(::Vector2{0, 0}, cam);
-        const raylib::Vector2 br = GetScreenToWorld2D(
-            ::Vector2{static_cast<float>(GetScreenWidth()), static_cast<float>(GetScreenHeight())}, cam);
+    static bool ensure_circle_texture() {
+        if (s_circle_tex.id != 0) return true;
+        constexpr int kSize = constants::body_texture_size;
+        constexpr float kCenter = 0.5F * static_cast<float>(kSize - 1);
+        constexpr float kRadius = 0.5F * static_cast<float>(kSize);
+        std::vector<Color> pixels(static_cast<std::size_t>(kSize * kSize));
+        for (int y = 0; y < kSize; ++y) {
+            for (int x = 0; x < kSize; ++x) {
+                const float dx = static_cast<float>(x) - kCenter;
+                const float dy = static_cast<float>(y) - kCenter;
+                // One texel of smooth falloff at the rim for anti-aliasing
+                const float cover = std::clamp(kRadius - std::sqrt(dx * dx + dy * dy), 0.0F, 1.0F);
+                pixels[static_cast<std::size_t>(y * kSize + x)] =
+                    Color{255, 255, 255, static_cast<unsigned char>(cover * 255.0F)};
+            }
+        }
+        const Image img{pixels.data(), kSize, kSize, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+        s_circle_tex = LoadTextureFromImage(img);
+        if (s_circle_tex.id == 0) return false;
+        SetTextureFilter(s_circle_tex, TEXTURE_FILTER_BILINEAR);
+        return true;
+    }
 
-        const float startX = std::floor(tl.x / spacing) * spacing;
-        const float endX = std::ceil(br.x / spacing) * spacing;
-        const float startY = std::floor(tl.y / spacing) * spacing;
-        const float endY = std::ceil(br.y / spacing) * spacing;
-
-        const int stepsX = static_cast<int>(
-            std::max(0.0f, std::floor((endX - startX) / spacing + nbody::constants::grid_steps_epsilon)));
-        for (int i = 0; i <= stepsX; ++i) {
-            const float x = startX + static_cast<float>(i) * spacing;
-            DrawLineV(::Vector2{x, startY}, ::Vector2{x, endY},
-                      (std::abs(x) < nbody::constants::grid_axis_epsilon) ? nbody::constants::axis_color
-                                                                          : nbody::constants::grid_color);
-        }
-        const int stepsY = static_cast<int>(
-            std::max(0.0f, std::floor((endY - startY) / spacing + nbody::constants::grid_steps_epsilon)));
-        for (int j = 0; j <= stepsY; ++j) {
-            const float y = startY + static_cast<float>(j) * spacing;
-            DrawLineV(::Vector2{startX, y}, ::Vector2{endX, y},
-                      (std::abs(y) < nbody::constants::grid_axis_epsilon) ? nbody::constants::axis_color
-                                                                          : nbody::constants::grid_color);
+    // Grid spacing adapts to zoom in powers of ten: minor lines are the smallest power of ten at least
+    // grid_min_px apart on screen (fading in as they open up), every tenth line is major, and the axes stand out.
+    // Lines are rebuilt only when the visible rectangle changes and submitted as one rlgl line batch.
+    static void draw_world_grid(const ViewRect& view, const float zoom) {
+        const GridCache& grid = grid_cache();
+        if (view.min_x != grid.view.min_x || view.min_y != grid.view.min_y || view.max_x != grid.view.max_x ||
+            view.max_y != grid.view.max_y || zoom != grid.zoom || grid.lines.empty()) {
+            build_grid(view, zoom);
+        }
+        rlSetTexture(0);
+        rlCheckRenderBatchLimit(static_cast<int>(2 * grid.lines.size()));
+        rlBegin(RL_LINES);
+        for (const GridLine& l : grid.lines) {
+            rlColor4ub(l.color.r, l.color.g, l.color.b, l.color.a);
+            rlVertex2f(l.x0, l.y0);
+            rlVertex2f(l.x1, l.y1);
+        }
+        rlEnd();
+    }
+
+    static void build_grid(const ViewRect& view, const float zoom) {
+        GridCache& grid = grid_cache();
+        grid.view = view;
+        grid.zoom = zoom;
+        grid.lines.clear();
+        const double minWorld = static_cast<double>(nbody::constants::grid_min_px) / static_cast<double>(zoom);
+        const double minor = std::pow(10.0, std::ceil(std::log10(minWorld)));
+        // 0 when minor lines are exactly grid_min_px apart, 1 when they are ten times that.
+        const double fade = std::clamp(std::log10(minor / minWorld), 0.0, 1.0);
+        Color minorColor = nbody::constants::grid_color;
+        minorColor.a = static_cast<unsigned char>(static_cast<double>(nbody::constants::grid_minor_alpha) * fade);
+
+        const auto lineColor = [&](const long long k) {
+            if (k == 0) return nbody::constants::axis_color;
+            return (k % nbody::constants::grid_major_every == 0) ? nbody::constants::grid_color : minorColor;
+        };
+        const auto kx0 = static_cast<long long>(std::floor(view.min_x / minor));
+        const auto kx1 = static_cast<long long>(std::ceil(view.max_x / minor));
+        const auto ky0 = static_cast<long long>(std::floor(view.min_y / minor));
+        const auto ky1 = static_cast<long long>(std::ceil(view.max_y / minor));
+        for (long long k = kx0; k <= kx1; ++k) {
+            const auto x = static_cast<float>(static_cast<double>(k) * minor);
+            grid.lines.push_back({x, view.min_y, x, view.max_y, lineColor(k)});
+        }
+        for (long long k = ky0; k <= ky1; ++k) {
+            const auto y = static_cast<float>(static_cast<double>(k) * minor);
+            grid.lines.push_back({view.min_x, y, view.max_x, y, lineColor(k)});
         }
     }
 };